@@ -61,6 +61,10 @@ class TauCOMRecipe(ConanFile):
 
     def package_info(self):
         self.cpp_info.libs = ["TauCOM"]
+
+        # The library links Threads::Threads publicly, static consumers need it too.
+        if self.settings.os in ["Linux", "FreeBSD"]:
+            self.cpp_info.system_libs = ["pthread"]
     
 
     
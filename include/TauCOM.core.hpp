@@ -0,0 +1,704 @@
+// ReSharper disable CppInconsistentNaming
+// ReSharper disable CppDFAUnreachableFunctionCall
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef TAU_COM_USE_TAU_UTILS
+#include <TauMacros.hpp>
+#endif
+
+#ifndef DYNAMIC_EXPORT
+    #if defined(_WIN32)
+      #define DYNAMIC_EXPORT __declspec(dllexport)
+    #elif defined(__GNUC__) || defined(__clang__)
+      #define DYNAMIC_EXPORT __attribute__((visibility("default")))
+    #else
+      #define DYNAMIC_EXPORT
+    #endif
+#endif
+
+#ifndef DYNAMIC_IMPORT
+    #if defined(_WIN32)
+      #define DYNAMIC_IMPORT __declspec(dllimport)
+    #elif defined(__GNUC__) || defined(__clang__)
+      #define DYNAMIC_IMPORT
+    #else
+      #define DYNAMIC_IMPORT
+    #endif
+#endif
+
+#ifdef TAU_COM_BUILD_SHARED
+  #define TAU_COM_LIB DYNAMIC_EXPORT
+#elif defined(TAU_COM_IMPORT_SHARED) || 1
+  #define TAU_COM_LIB DYNAMIC_IMPORT
+#elif defined(TAU_COM_BUILD_STATIC)
+  #define TAU_COM_LIB
+#endif
+
+namespace tau::com {
+
+struct UUID final
+{
+public:
+    ::std::uint64_t Low;
+    ::std::uint64_t High;
+public:
+    constexpr UUID() noexcept = default;
+
+    constexpr UUID(const ::std::uint64_t low, const ::std::uint64_t high) noexcept
+        : Low(low)
+        , High(high)
+    { }
+
+    constexpr ~UUID() noexcept = default;
+
+    constexpr UUID(const UUID& copy) noexcept = default;
+    constexpr UUID(UUID&& move) noexcept = default;
+
+    constexpr UUID& operator=(const UUID& copy) noexcept = default;
+    constexpr UUID& operator=(UUID&& move) noexcept = default;
+
+    [[nodiscard]] constexpr bool operator ==(const UUID& other) const noexcept { return Low == other.Low && High == other.High; }
+    [[nodiscard]] constexpr bool operator !=(const UUID& other) const noexcept { return !((*this) == other); }
+};
+
+// ReSharper disable once CppTemplateParameterNeverUsed
+template<typename T>
+struct ComUUID final
+{
+    // ReSharper disable once CppRedundantInlineSpecifier
+    static inline constexpr UUID IID = UUID(0x0000000000000000ull, 0x0000000000000000ull);
+};
+
+#define TAU_DECL_UUID(T, LOW, HIGH) \
+    namespace tau::com { \
+    template<> \
+    struct ComUUID<T> final { \
+        static inline constexpr ::tau::com::UUID IID = ::tau::com::UUID((LOW), (HIGH)); \
+    }; \
+    }
+
+template<typename T>
+inline constexpr const UUID& uuid_of = ComUUID<T>::IID;
+
+template<typename T>
+inline constexpr const UUID& iid_of = ComUUID<T>::IID;
+
+enum EResultCode : ::std::int32_t
+{
+    RC_Success = 0,
+    RC_NullParam = -1,
+    RC_InterfaceNotFound = -2,
+    RC_Fail = -3,
+    RC_InitializationError = -4,
+    RC_InvalidParam = -5,
+    RC_OutOfMemory = -6,
+    RC_NotReady = -7,
+    RC_NoAggregation = -8,
+    RC_FactoryAlreadyRegistered = 1,
+    RC_Timeout = 2,
+    RC_AsyncReturn = 3,
+    RC_MoreItems = 4,
+};
+
+inline bool IsSuccess(const EResultCode result) noexcept { return static_cast<::std::int32_t>(result) >= 0; }
+inline bool IsFailure(const EResultCode result) noexcept { return !IsSuccess(result); }
+
+// A dense index assigned to an IID the first time it is interned. Handles are
+// only stable for the lifetime of the process, UUIDs remain the ABI identity.
+enum class IidHandle : ::std::uint32_t
+{
+    Invalid = 0xFFFFFFFF
+};
+
+}
+
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComInternIid(const ::tau::com::UUID& iid, ::tau::com::IidHandle* const pHandle) noexcept;
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComGetInternedIid(const ::tau::com::IidHandle handle, ::tau::com::UUID* const pIid) noexcept;
+
+namespace tau::com {
+
+template<typename T>
+struct ComIidHandle final
+{
+    [[nodiscard]] static IidHandle Get() noexcept
+    {
+        static const IidHandle s_Handle = Intern();
+        return s_Handle;
+    }
+private:
+    [[nodiscard]] static IidHandle Intern() noexcept
+    {
+        IidHandle handle;
+        if(IsFailure(TauComInternIid(iid_of<T>, &handle)))
+        {
+            return IidHandle::Invalid;
+        }
+        return handle;
+    }
+};
+
+template<typename T>
+[[nodiscard]] inline IidHandle iid_handle_of() noexcept
+{
+    return ComIidHandle<T>::Get();
+}
+
+struct BaseConstructionInfo
+{
+public:
+    UUID Iid;
+    const BaseConstructionInfo* pNext;
+public:
+    BaseConstructionInfo() noexcept = default;
+    virtual ~BaseConstructionInfo() noexcept = default;
+
+    BaseConstructionInfo(const BaseConstructionInfo& copy) noexcept = default;
+    BaseConstructionInfo(BaseConstructionInfo&& move) noexcept = default;
+
+    BaseConstructionInfo& operator=(const BaseConstructionInfo& copy) noexcept = default;
+    BaseConstructionInfo& operator=(BaseConstructionInfo&& move) noexcept = default;
+};
+
+/**
+ * Walks the pNext chain for the node of type T. T must derive from
+ * BaseConstructionInfo and have its own UUID.
+ */
+template<typename T>
+[[nodiscard]] inline const T* FindConstructionInfo(const BaseConstructionInfo* pConstructionInfo) noexcept
+{
+    for(; pConstructionInfo; pConstructionInfo = pConstructionInfo->pNext)
+    {
+        if(pConstructionInfo->Iid == iid_of<T>)
+        {
+            return static_cast<const T*>(pConstructionInfo);
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Slot of the open addressed table a ConstructionInfoBuilder indexes its
+ * extensions with. A Size of 0 marks an empty slot.
+ */
+struct ConstructionExtensionSlot final
+{
+    UUID Iid;
+    ::std::uint32_t Offset;
+    ::std::uint32_t Size;
+};
+
+/**
+ * The single chain node a ConstructionInfoBuilder hands to factories. The
+ * extensions it carries are plain structs packed into the builder's buffer,
+ * they have no vtable and no pNext of their own.
+ */
+struct PackedConstructionInfo final : BaseConstructionInfo
+{
+public:
+    const ::std::byte* pData;
+    const ConstructionExtensionSlot* pSlots;
+    ::std::uint32_t SlotMask;
+public:
+    inline PackedConstructionInfo(const ::std::byte* const data, const ConstructionExtensionSlot* const slots, const ::std::uint32_t slotMask, const BaseConstructionInfo* const next) noexcept;
+    ~PackedConstructionInfo() noexcept override = default;
+
+    PackedConstructionInfo(const PackedConstructionInfo& copy) noexcept = default;
+    PackedConstructionInfo(PackedConstructionInfo&& move) noexcept = default;
+
+    PackedConstructionInfo& operator=(const PackedConstructionInfo& copy) noexcept = default;
+    PackedConstructionInfo& operator=(PackedConstructionInfo&& move) noexcept = default;
+
+    [[nodiscard]] static inline bool IsPacked(const BaseConstructionInfo* const pConstructionInfo) noexcept;
+
+    [[nodiscard]] static ::std::uint32_t SlotHash(const UUID& iid) noexcept
+    {
+        const ::std::uint64_t mix = iid.Low ^ iid.High;
+        return static_cast<::std::uint32_t>(mix ^ (mix >> 32));
+    }
+
+    [[nodiscard]] const void* Find(const UUID& iid) const noexcept
+    {
+        for(::std::uint32_t i = SlotHash(iid) & SlotMask; pSlots[i].Size != 0; i = (i + 1) & SlotMask)
+        {
+            if(pSlots[i].Iid == iid)
+            {
+                return pData + pSlots[i].Offset;
+            }
+        }
+
+        return nullptr;
+    }
+
+    template<typename T>
+    [[nodiscard]] const T* Find() const noexcept
+    {
+        return static_cast<const T*>(Find(iid_of<T>));
+    }
+};
+
+/**
+ * Packs typed extension structs into one stack buffer so construction
+ * parameters can be built and parsed without touching the heap. Extensions
+ * must be trivially destructible, non-polymorphic and have their own UUID.
+ * Add returns nullptr if the builder is full or T was already added.
+ *
+ * The builder is referenced by the chain it produces, so it must outlive the
+ * CreateObject call it is passed to and cannot be copied.
+ */
+template<::std::size_t MaxExtensions = 8, ::std::size_t BufferSize = 256>
+class ConstructionInfoBuilder final
+{
+    static_assert(MaxExtensions > 0, "A builder needs room for at least one extension.");
+    static_assert(BufferSize <= 0xFFFFFFFF, "Extension offsets are stored as 32 bit values.");
+private:
+    [[nodiscard]] static constexpr ::std::size_t ComputeSlotCount() noexcept
+    {
+        // Keep the table at most half full so probes stay short and always terminate.
+        ::std::size_t slotCount = 1;
+        while(slotCount < MaxExtensions * 2)
+        {
+            slotCount <<= 1;
+        }
+        return slotCount;
+    }
+
+    static constexpr ::std::size_t SlotCount = ComputeSlotCount();
+    static constexpr ::std::uint32_t SlotMask = static_cast<::std::uint32_t>(SlotCount - 1);
+public:
+    explicit ConstructionInfoBuilder(const BaseConstructionInfo* const next = nullptr) noexcept
+        : m_Slots { }
+        , m_Used(0)
+        , m_Count(0)
+        , m_Head(m_Buffer, m_Slots, SlotMask, next)
+    { }
+
+    ~ConstructionInfoBuilder() noexcept = default;
+
+    ConstructionInfoBuilder(const ConstructionInfoBuilder& copy) noexcept = delete;
+    ConstructionInfoBuilder(ConstructionInfoBuilder&& move) noexcept = delete;
+
+    ConstructionInfoBuilder& operator=(const ConstructionInfoBuilder& copy) noexcept = delete;
+    ConstructionInfoBuilder& operator=(ConstructionInfoBuilder&& move) noexcept = delete;
+
+    template<typename T, typename... Args>
+    T* Add(Args&&... args) noexcept
+    {
+        static_assert(::std::is_trivially_destructible_v<T>, "Construction extensions are never destroyed.");
+        static_assert(!::std::is_polymorphic_v<T>, "Construction extensions must not carry a vtable.");
+        static_assert(alignof(T) <= alignof(::std::max_align_t), "Construction extensions cannot be over-aligned.");
+        static_assert(iid_of<T> != UUID(), "Construction extensions need a UUID, declare one with TAU_DECL_UUID.");
+
+        if(m_Count == MaxExtensions)
+        {
+            return nullptr;
+        }
+
+        const UUID& iid = iid_of<T>;
+
+        ::std::uint32_t index = PackedConstructionInfo::SlotHash(iid) & SlotMask;
+        for(; m_Slots[index].Size != 0; index = (index + 1) & SlotMask)
+        {
+            if(m_Slots[index].Iid == iid)
+            {
+                return nullptr;
+            }
+        }
+
+        const ::std::size_t offset = (m_Used + alignof(T) - 1) & ~(alignof(T) - 1);
+        if(offset + sizeof(T) > BufferSize)
+        {
+            return nullptr;
+        }
+
+        T* const extension = ::new(m_Buffer + offset) T { ::std::forward<Args>(args)... };
+
+        m_Slots[index].Iid = iid;
+        m_Slots[index].Offset = static_cast<::std::uint32_t>(offset);
+        m_Slots[index].Size = static_cast<::std::uint32_t>(sizeof(T));
+
+        m_Used = offset + sizeof(T);
+        ++m_Count;
+
+        return extension;
+    }
+
+    [[nodiscard]] const BaseConstructionInfo* Get() const noexcept { return &m_Head; }
+private:
+    alignas(::std::max_align_t) ::std::byte m_Buffer[BufferSize];
+    ConstructionExtensionSlot m_Slots[SlotCount];
+    ::std::size_t m_Used;
+    ::std::size_t m_Count;
+    PackedConstructionInfo m_Head;
+};
+
+/**
+ * Finds extension T anywhere in a construction info chain. Packed nodes are
+ * searched by hash, if T derives from BaseConstructionInfo plain chain nodes
+ * are matched by IID like FindConstructionInfo does.
+ */
+template<typename T>
+[[nodiscard]] inline const T* FindConstructionExtension(const BaseConstructionInfo* pConstructionInfo) noexcept
+{
+    for(; pConstructionInfo; pConstructionInfo = pConstructionInfo->pNext)
+    {
+        if(PackedConstructionInfo::IsPacked(pConstructionInfo))
+        {
+            if(const T* const extension = static_cast<const PackedConstructionInfo*>(pConstructionInfo)->Find<T>())
+            {
+                return extension;
+            }
+        }
+        else if constexpr(::std::is_base_of_v<BaseConstructionInfo, T>)
+        {
+            if(pConstructionInfo->Iid == iid_of<T>)
+            {
+                return static_cast<const T*>(pConstructionInfo);
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+class IUnknown
+{
+public:
+    using ConstructionInfo = BaseConstructionInfo;
+protected:
+    IUnknown() noexcept = default;
+public:
+    virtual ~IUnknown() noexcept = default;
+protected:
+    IUnknown(const IUnknown& copy) noexcept = default;
+    IUnknown(IUnknown&& move) noexcept = default;
+
+    IUnknown& operator=(const IUnknown& copy) noexcept = default;
+    IUnknown& operator=(IUnknown&& move) noexcept = default;
+public:
+    virtual ::std::int32_t AddReference() noexcept = 0;
+    virtual ::std::int32_t ReleaseReference() noexcept = 0;
+
+    virtual EResultCode QueryInterface(const UUID& iid, void** const pInterface) noexcept = 0;
+
+    template<typename T>
+    EResultCode QueryInterface(T** pInterface) noexcept
+    {
+        return QueryInterface(iid_of<T>, reinterpret_cast<void**>(pInterface));
+    }
+};
+
+
+/**
+ * Implemented by components that can be aggregated into an outer object.
+ * Once aggregated, the IUnknown methods of every interface delegate to the
+ * outer object, while the outer object reaches the inner one through these.
+ */
+class IAggregatable : public IUnknown
+{
+protected:
+    IAggregatable() noexcept = default;
+public:
+    ~IAggregatable() noexcept override = default;
+protected:
+    IAggregatable(const IAggregatable& copy) noexcept = default;
+    IAggregatable(IAggregatable&& move) noexcept = default;
+
+    IAggregatable& operator=(const IAggregatable& copy) noexcept = default;
+    IAggregatable& operator=(IAggregatable&& move) noexcept = default;
+public:
+    virtual EResultCode QueryInnerInterface(const UUID& iid, void** const pInterface) noexcept = 0;
+    // Drops the reference the outer object holds on the inner one.
+    virtual ::std::int32_t ReleaseInner() noexcept = 0;
+};
+
+/**
+ * Prepended to the construction info chain to ask a factory for an
+ * aggregated object. A factory that supports aggregation calls Accept and
+ * returns the IAggregatable of the new object regardless of the requested
+ * IID. If nothing accepted the request the manager releases whatever the
+ * factory returned and fails with RC_NoAggregation.
+ */
+struct AggregationInfo final : BaseConstructionInfo
+{
+public:
+    IUnknown* pOuter;
+    mutable bool Accepted;
+public:
+    inline AggregationInfo(IUnknown* const outer, const BaseConstructionInfo* const next) noexcept;
+    ~AggregationInfo() noexcept override = default;
+
+    AggregationInfo(const AggregationInfo& copy) noexcept = default;
+    AggregationInfo(AggregationInfo&& move) noexcept = default;
+
+    AggregationInfo& operator=(const AggregationInfo& copy) noexcept = default;
+    AggregationInfo& operator=(AggregationInfo&& move) noexcept = default;
+
+    void Accept() const noexcept { Accepted = true; }
+};
+
+template<typename T>
+class ComRef final
+{
+public:
+    ComRef() noexcept
+        : m_Ptr(nullptr)
+    { }
+
+    ComRef(T* const ptr) noexcept
+        : m_Ptr(ptr)
+    { }
+
+    ComRef(::std::nullptr_t) noexcept
+        : m_Ptr(nullptr)
+    { }
+
+    ~ComRef() noexcept
+    {
+        ReleaseReference();
+    }
+
+    ComRef(const ComRef<T>& copy) noexcept
+        : m_Ptr(copy.m_Ptr)
+    {
+        AddReference();
+    }
+
+    ComRef(ComRef<T>&& move) noexcept
+        : m_Ptr(move.m_Ptr)
+    {
+        move.m_Ptr = nullptr;
+    }
+
+    ComRef<T>& operator=(::std::nullptr_t) noexcept
+    {
+        ReleaseReference();
+
+        m_Ptr = nullptr;
+
+        return *this;
+    }
+
+    ComRef<T>& operator=(const ComRef<T>& copy) noexcept
+    {
+        if(this == &copy)
+        {
+            return *this;
+        }
+
+        ReleaseReference();
+
+        m_Ptr = copy.m_Ptr;
+        AddReference();
+
+        return *this;
+    }
+
+    ComRef<T>& operator=(ComRef<T>&& move) noexcept
+    {
+        if(this == &move)
+        {
+            return *this;
+        }
+
+        ReleaseReference();
+
+        m_Ptr = move.m_Ptr;
+        move.m_Ptr = nullptr;
+
+        return *this;
+    }
+
+    [[nodiscard]] operator T*() const noexcept { return m_Ptr; }
+    [[nodiscard]] operator bool() const noexcept { return m_Ptr; }
+
+    [[nodiscard]] T* operator->() const noexcept { return m_Ptr; }
+
+    [[nodiscard]] T* Get() const noexcept { return m_Ptr; }
+    [[nodiscard]] T** Load() noexcept { return &m_Ptr; }
+    [[nodiscard]] void** LoadVoid() noexcept { return reinterpret_cast<void**>(&m_Ptr); }
+
+    [[nodiscard]] bool operator==(const ComRef<T>& other) const noexcept { return m_Ptr == other.m_Ptr; }
+    [[nodiscard]] bool operator!=(const ComRef<T>& other) const noexcept { return !(*this == other); }
+
+    ::std::int32_t AddReference() noexcept
+    {
+        if(m_Ptr)
+        {
+            return m_Ptr->AddReference();
+        }
+        return 0;
+    }
+
+    ::std::int32_t ReleaseReference() noexcept
+    {
+        if(m_Ptr)
+        {
+            return m_Ptr->ReleaseReference();
+        }
+        return 0;
+    }
+private:
+    T* m_Ptr;
+};
+
+class IWeakReference : public IUnknown
+{
+protected:
+    IWeakReference() noexcept = default;
+public:
+    ~IWeakReference() noexcept override = default;
+protected:
+    IWeakReference(const IWeakReference& copy) noexcept = default;
+    IWeakReference(IWeakReference&& move) noexcept = default;
+
+    IWeakReference& operator=(const IWeakReference& copy) noexcept = default;
+    IWeakReference& operator=(IWeakReference&& move) noexcept = default;
+public:
+    /**
+     * Returns a strong reference to the target if it is still alive, or
+     * RC_NotReady once its last strong reference has been released.
+     */
+    virtual EResultCode Resolve(const UUID& iid, void** const pInterface) noexcept = 0;
+
+    template<typename T>
+    EResultCode Resolve(T** pInterface) noexcept
+    {
+        return Resolve(iid_of<T>, reinterpret_cast<void**>(pInterface));
+    }
+};
+
+class IWeakReferenceSource : public IUnknown
+{
+protected:
+    IWeakReferenceSource() noexcept = default;
+public:
+    ~IWeakReferenceSource() noexcept override = default;
+protected:
+    IWeakReferenceSource(const IWeakReferenceSource& copy) noexcept = default;
+    IWeakReferenceSource(IWeakReferenceSource&& move) noexcept = default;
+
+    IWeakReferenceSource& operator=(const IWeakReferenceSource& copy) noexcept = default;
+    IWeakReferenceSource& operator=(IWeakReferenceSource&& move) noexcept = default;
+public:
+    virtual EResultCode GetWeakReference(IWeakReference** const pWeakReference) noexcept = 0;
+};
+
+struct Event final
+{
+public:
+    UUID Iid;
+    const void* pData;
+    ::std::size_t DataSize;
+};
+
+class IEventSink : public IUnknown
+{
+protected:
+    IEventSink() noexcept = default;
+public:
+    ~IEventSink() noexcept override = default;
+protected:
+    IEventSink(const IEventSink& copy) noexcept = default;
+    IEventSink(IEventSink&& move) noexcept = default;
+
+    IEventSink& operator=(const IEventSink& copy) noexcept = default;
+    IEventSink& operator=(IEventSink&& move) noexcept = default;
+public:
+    virtual void OnEvents(const UUID& topic, const Event* const pEvents, const ::std::size_t eventCount) noexcept = 0;
+};
+
+enum ESubscribeFlags : ::std::uint32_t
+{
+    SF_None = 0,
+    // Only hold a weak reference to the sink, it is unsubscribed once it dies.
+    SF_Weak = 1 << 0,
+};
+
+class IEventHub : public IUnknown
+{
+protected:
+    IEventHub() noexcept = default;
+public:
+    ~IEventHub() noexcept override = default;
+protected:
+    IEventHub(const IEventHub& copy) noexcept = default;
+    IEventHub(IEventHub&& move) noexcept = default;
+
+    IEventHub& operator=(const IEventHub& copy) noexcept = default;
+    IEventHub& operator=(IEventHub&& move) noexcept = default;
+public:
+    virtual EResultCode Subscribe(const UUID& topic, IEventSink* const pSink, const ESubscribeFlags flags, ::std::uint64_t* const pCookie) noexcept = 0;
+    virtual EResultCode Unsubscribe(const ::std::uint64_t cookie) noexcept = 0;
+    /**
+     * Delivers the whole batch to each subscriber of the topic with a single
+     * OnEvents call. Never blocks on concurrent subscription changes.
+     */
+    virtual EResultCode Publish(const UUID& topic, const Event* const pEvents, const ::std::size_t eventCount) noexcept = 0;
+};
+
+struct ObjectLayout final
+{
+public:
+    ::std::size_t Size;
+    ::std::size_t Alignment;
+public:
+    template<typename T>
+    [[nodiscard]] static constexpr ObjectLayout Of() noexcept { return { sizeof(T), alignof(T) }; }
+};
+
+}
+
+TAU_DECL_UUID(::tau::com::IUnknown, 0x89D0171D1E547699ull, 0x3513C89A25664A40ull);
+TAU_DECL_UUID(::tau::com::IAggregatable, 0x0B7E4D29F6A1C385ull, 0xE52F8A71D03C946Bull);
+TAU_DECL_UUID(::tau::com::PackedConstructionInfo, 0x3E8C15A7D2F96B40ull, 0xA06D4F8B17E2C359ull);
+TAU_DECL_UUID(::tau::com::AggregationInfo, 0x9C36F0B84E2D1A57ull, 0x47A1E6D32B9F08C5ull);
+TAU_DECL_UUID(::tau::com::IWeakReference, 0x4D2A9E71C3B05F86ull, 0x91E7D4B2A6C8305Full);
+TAU_DECL_UUID(::tau::com::IWeakReferenceSource, 0xE3F18B6A2D47C905ull, 0x5B0C96E1F4A27D38ull);
+TAU_DECL_UUID(::tau::com::IEventSink, 0x7A95C2E04B1D36F8ull, 0xC6283F5DE9A14B07ull);
+TAU_DECL_UUID(::tau::com::IEventHub, 0x1F4B7D93E6A2C058ull, 0x28D5E0B7C3F96A14ull);
+
+inline ::tau::com::PackedConstructionInfo::PackedConstructionInfo(const ::std::byte* const data, const ConstructionExtensionSlot* const slots, const ::std::uint32_t slotMask, const BaseConstructionInfo* const next) noexcept
+    : pData(data)
+    , pSlots(slots)
+    , SlotMask(slotMask)
+{
+    Iid = iid_of<PackedConstructionInfo>;
+    pNext = next;
+}
+
+inline bool ::tau::com::PackedConstructionInfo::IsPacked(const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    return pConstructionInfo->Iid == iid_of<PackedConstructionInfo>;
+}
+
+inline ::tau::com::AggregationInfo::AggregationInfo(IUnknown* const outer, const BaseConstructionInfo* const next) noexcept
+    : pOuter(outer)
+    , Accepted(false)
+{
+    Iid = iid_of<AggregationInfo>;
+    pNext = next;
+}
+
+/**
+ * Objects using TAU_COM_IMPL_DEFERRED_REF_COUNT are destroyed on a background
+ * thread while the reclaimer runs. Drain blocks until everything queued so
+ * far, and anything queued by those destructors, has been destroyed. Called
+ * from a deferred destructor it only destroys what is pending.
+ *
+ * Every Start must be matched by a Stop before the state deferred destructors
+ * rely on is torn down or the library is unloaded. Stop drains before
+ * returning. Stopped from a deferred destructor the old thread finishes its
+ * batch and exits on its own, the next Start or the exit hook joins it. As a
+ * last resort an exit hook stops a reclaimer that is still running when the
+ * process exits.
+ */
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComStartReclaimer() noexcept;
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComStopReclaimer() noexcept;
+extern "C" TAU_COM_LIB void TauComDrainReclaimer() noexcept;
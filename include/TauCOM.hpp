@@ -2,70 +2,12 @@
 // ReSharper disable CppDFAUnreachableFunctionCall
 #pragma once
 
+// The component manager and the UUID hash specializations it needs. Code that
+// only uses IUnknown, ComRef or the implementation macros can include
+// TauCOM.core.hpp and skip the standard containers.
+#include "TauCOM.core.hpp"
 #include <unordered_map>
 #include <functional>
-#include <cstdint>
-
-#ifdef TAU_COM_USE_TAU_UTILS
-#include <TauMacros.hpp>
-#endif
-
-#ifndef DYNAMIC_EXPORT
-    #if defined(_WIN32)
-      #define DYNAMIC_EXPORT __declspec(dllexport)
-    #elif defined(__GNUC__) || defined(__clang__)
-      #define DYNAMIC_EXPORT __attribute__((visibility("default")))
-    #else
-      #define DYNAMIC_EXPORT
-    #endif
-#endif
-
-#ifndef DYNAMIC_IMPORT
-    #if defined(_WIN32)
-      #define DYNAMIC_IMPORT __declspec(dllimport)
-    #elif defined(__GNUC__) || defined(__clang__)
-      #define DYNAMIC_IMPORT
-    #else
-      #define DYNAMIC_IMPORT
-    #endif
-#endif
-
-#ifdef TAU_COM_BUILD_SHARED
-  #define TAU_COM_LIB DYNAMIC_EXPORT
-#elif defined(TAU_COM_IMPORT_SHARED) || 1
-  #define TAU_COM_LIB DYNAMIC_IMPORT
-#elif defined(TAU_COM_BUILD_STATIC)
-  #define TAU_COM_LIB
-#endif
-
-namespace tau::com {
-
-struct UUID final
-{
-public:
-    ::std::uint64_t Low;
-    ::std::uint64_t High;
-public:
-    constexpr UUID() noexcept = default;
-
-    constexpr UUID(const ::std::uint64_t low, const ::std::uint64_t high) noexcept
-        : Low(low)
-        , High(high)
-    { }
-
-    constexpr ~UUID() noexcept = default;
-
-    constexpr UUID(const UUID& copy) noexcept = default;
-    constexpr UUID(UUID&& move) noexcept = default;
-
-    constexpr UUID& operator=(const UUID& copy) noexcept = default;
-    constexpr UUID& operator=(UUID&& move) noexcept = default;
-
-    [[nodiscard]] constexpr bool operator ==(const UUID& other) const noexcept { return Low == other.Low && High == other.High; }
-    [[nodiscard]] constexpr bool operator !=(const UUID& other) const noexcept { return !((*this) == other); }
-};
-
-}
 
 namespace std {
 
@@ -110,196 +52,6 @@ struct hash<::tau::com::UUID>
 
 namespace tau::com {
 
-// ReSharper disable once CppTemplateParameterNeverUsed
-template<typename T>
-struct ComUUID final
-{
-    // ReSharper disable once CppRedundantInlineSpecifier
-    static inline constexpr UUID IID = UUID(0x0000000000000000ull, 0x0000000000000000ull);
-};
-
-#define TAU_DECL_UUID(T, LOW, HIGH) \
-    namespace tau::com { \
-    template<> \
-    struct ComUUID<T> final { \
-        static inline constexpr ::tau::com::UUID IID = ::tau::com::UUID((LOW), (HIGH)); \
-    }; \
-    }
-
-template<typename T>
-inline constexpr const UUID& uuid_of = ComUUID<T>::IID;
-
-template<typename T>
-inline constexpr const UUID& iid_of = ComUUID<T>::IID;
-
-enum EResultCode : ::std::int32_t
-{
-    RC_Success = 0,
-    RC_NullParam = -1,
-    RC_InterfaceNotFound = -2,
-    RC_Fail = -3,
-    RC_InitializationError = -4,
-    RC_InvalidParam = -5,
-    RC_OutOfMemory = -6,
-    RC_NotReady = -7,
-    RC_FactoryAlreadyRegistered = 1,
-    RC_Timeout = 2,
-    RC_AsyncReturn = 3,
-    RC_MoreItems = 4,
-};
-
-static bool IsSuccess(const EResultCode result) noexcept { return static_cast<::std::int32_t>(result) >= 0; }
-static bool IsFailure(const EResultCode result) noexcept { return !IsSuccess(result); }
-
-struct BaseConstructionInfo
-{
-public:
-    UUID Iid;
-    const BaseConstructionInfo* pNext;
-public:
-    BaseConstructionInfo() noexcept = default;
-    virtual ~BaseConstructionInfo() noexcept = default;
-
-    BaseConstructionInfo(const BaseConstructionInfo& copy) noexcept = default;
-    BaseConstructionInfo(BaseConstructionInfo&& move) noexcept = default;
-
-    BaseConstructionInfo& operator=(const BaseConstructionInfo& copy) noexcept = default;
-    BaseConstructionInfo& operator=(BaseConstructionInfo&& move) noexcept = default;
-};
-
-class IUnknown
-{
-public:
-    using ConstructionInfo = BaseConstructionInfo;
-protected:
-    IUnknown() noexcept = default;
-public:
-    virtual ~IUnknown() noexcept = default;
-protected:
-    IUnknown(const IUnknown& copy) noexcept = default;
-    IUnknown(IUnknown&& move) noexcept = default;
-
-    IUnknown& operator=(const IUnknown& copy) noexcept = default;
-    IUnknown& operator=(IUnknown&& move) noexcept = default;
-public:
-    virtual ::std::int32_t AddReference() noexcept = 0;
-    virtual ::std::int32_t ReleaseReference() noexcept = 0;
-
-    virtual EResultCode QueryInterface(const UUID& iid, void** const pInterface) noexcept = 0;
-
-    template<typename T>
-    EResultCode QueryInterface(T** pInterface) noexcept
-    {
-        return QueryInterface(iid_of<T>, reinterpret_cast<void**>(pInterface));
-    }
-};
-
-
-template<typename T>
-class ComRef final
-{
-public:
-    ComRef() noexcept
-        : m_Ptr(nullptr)
-    { }
-
-    ComRef(T* const ptr) noexcept
-        : m_Ptr(ptr)
-    { }
-
-    ComRef(::std::nullptr_t) noexcept
-        : m_Ptr(nullptr)
-    { }
-
-    ~ComRef() noexcept
-    {
-        ReleaseReference();
-    }
-
-    ComRef(const ComRef<T>& copy) noexcept
-        : m_Ptr(copy.m_Ptr)
-    {
-        AddReference();
-    }
-
-    ComRef(ComRef<T>&& move) noexcept
-        : m_Ptr(move.m_Ptr)
-    {
-        move.m_Ptr = nullptr;
-    }
-
-    ComRef<T>& operator=(::std::nullptr_t) noexcept
-    {
-        ReleaseReference();
-
-        m_Ptr = nullptr;
-
-        return *this;
-    }
-
-    ComRef<T>& operator=(const ComRef<T>& copy) noexcept
-    {
-        if(this == &copy)
-        {
-            return *this;
-        }
-
-        ReleaseReference();
-
-        m_Ptr = copy.m_Ptr;
-        AddReference();
-
-        return *this;
-    }
-
-    ComRef<T>& operator=(ComRef<T>&& move) noexcept
-    {
-        if(this == &move)
-        {
-            return *this;
-        }
-
-        ReleaseReference();
-
-        m_Ptr = move.m_Ptr;
-        move.m_Ptr = nullptr;
-
-        return *this;
-    }
-
-    [[nodiscard]] operator T*() const noexcept { return m_Ptr; }
-    [[nodiscard]] operator bool() const noexcept { return m_Ptr; }
-
-    [[nodiscard]] T* operator->() const noexcept { return m_Ptr; }
-
-    [[nodiscard]] T* Get() const noexcept { return m_Ptr; }
-    [[nodiscard]] T** Load() noexcept { return &m_Ptr; }
-    [[nodiscard]] void** LoadVoid() noexcept { return reinterpret_cast<void**>(&m_Ptr); }
-
-    [[nodiscard]] bool operator==(const ComRef<T>& other) const noexcept { return m_Ptr == other.m_Ptr; }
-    [[nodiscard]] bool operator!=(const ComRef<T>& other) const noexcept { return !(*this == other); }
-
-    ::std::int32_t AddReference() noexcept
-    {
-        if(m_Ptr)
-        {
-            return m_Ptr->AddReference();
-        }
-        return 0;
-    }
-
-    ::std::int32_t ReleaseReference() noexcept
-    {
-        if(m_Ptr)
-        {
-            return m_Ptr->ReleaseReference();
-        }
-        return 0;
-    }
-private:
-    T* m_Ptr;
-};
-
 class IComManager : public IUnknown
 {
 public:
@@ -320,6 +72,13 @@ public:
         ConstructionInfo& operator=(const ConstructionInfo& copy) noexcept = default;
         ConstructionInfo& operator=(ConstructionInfo&& move) noexcept = default;
     };
+
+    // Lets a manager be created with another manager's factories without
+    // copying the map into the construction info first.
+    struct FactoriesExtension final
+    {
+        const FactoryMap* pFactories;
+    };
 protected:
     IComManager() noexcept = default;
 public:
@@ -346,6 +105,38 @@ public:
     {
         return CreateObject(iid_of<T>, reinterpret_cast<void**>(pInterface), nullptr);
     }
+
+    template<typename T>
+    EResultCode CreateAggregatedObject(IUnknown* const pOuter, IAggregatable** const pInner, const BaseConstructionInfo* const pConstructionInfo = nullptr) noexcept
+    {
+        if(!pOuter || !pInner)
+        {
+            return RC_NullParam;
+        }
+
+        *pInner = nullptr;
+
+        const AggregationInfo aggregationInfo(pOuter, pConstructionInfo);
+        void* object = nullptr;
+        const EResultCode result = CreateObject(iid_of<T>, &object, &aggregationInfo);
+
+        if(IsFailure(result))
+        {
+            return result;
+        }
+
+        // Managers reject factories that ignored the request, this also covers
+        // implementations that don't. Such a factory returned a T, whose first
+        // base is an IUnknown like every interface.
+        if(!aggregationInfo.Accepted)
+        {
+            (void) static_cast<IUnknown*>(object)->ReleaseReference();
+            return RC_NoAggregation;
+        }
+
+        *pInner = static_cast<IAggregatable*>(object);
+        return result;
+    }
 };
 
 class IComManager1 : public IComManager
@@ -366,10 +157,93 @@ public:
     virtual EResultCode Duplicate(IComManager1** const comManager) noexcept = 0;
 };
 
+
+class IComManager2 : public IComManager1
+{
+public:
+    /**
+     * Constructs the object into caller provided storage rather than
+     * allocating it. The storage must satisfy the layout the factory was
+     * registered with. When the last reference is released the object is
+     * destructed, but the storage is left to the caller.
+     */
+    using ComPlacementFactoryFunc = EResultCode(*)(const UUID& iid, void* pStorage, void** pInterface, const BaseConstructionInfo* const pConstructionInfo);
+protected:
+    IComManager2() noexcept = default;
+public:
+    ~IComManager2() noexcept override = default;
+protected:
+    IComManager2(const IComManager2& copy) noexcept = default;
+    IComManager2(IComManager2&& move) noexcept = default;
+
+    IComManager2& operator=(const IComManager2& copy) noexcept = default;
+    IComManager2& operator=(IComManager2&& move) noexcept = default;
+public:
+    virtual EResultCode RegisterIidPlacementFactory(const UUID& iid, const ObjectLayout& layout, const ComPlacementFactoryFunc factory) noexcept = 0;
+    virtual EResultCode UnregisterIidPlacementFactory(const UUID& iid) noexcept = 0;
+    virtual EResultCode GetIidObjectLayout(const UUID& iid, ObjectLayout* const pLayout) noexcept = 0;
+    virtual EResultCode CreateObjectInPlace(const UUID& iid, void* const pStorage, const ::std::size_t storageSize, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept = 0;
+
+    template<typename T>
+    EResultCode GetIidObjectLayout(ObjectLayout* const pLayout) noexcept
+    {
+        return GetIidObjectLayout(iid_of<T>, pLayout);
+    }
+
+    template<typename T>
+    // ReSharper disable once CppRedundantTypenameKeyword
+    EResultCode CreateObjectInPlace(void* const pStorage, const ::std::size_t storageSize, T** const pInterface, const typename T::ConstructionInfo* const pConstructionInfo) noexcept
+    {
+        return CreateObjectInPlace(iid_of<T>, pStorage, storageSize, reinterpret_cast<void**>(pInterface), static_cast<const BaseConstructionInfo*>(pConstructionInfo));
+    }
+
+    template<typename T>
+    EResultCode CreateObjectInPlace(void* const pStorage, const ::std::size_t storageSize, T** const pInterface) noexcept
+    {
+        return CreateObjectInPlace(iid_of<T>, pStorage, storageSize, reinterpret_cast<void**>(pInterface), nullptr);
+    }
+};
+
+class IComManager3 : public IComManager2
+{
+protected:
+    IComManager3() noexcept = default;
+public:
+    ~IComManager3() noexcept override = default;
+protected:
+    IComManager3(const IComManager3& copy) noexcept = default;
+    IComManager3(IComManager3&& move) noexcept = default;
+
+    IComManager3& operator=(const IComManager3& copy) noexcept = default;
+    IComManager3& operator=(IComManager3&& move) noexcept = default;
+public:
+    using IComManager::CreateObject;
+    using IComManager1::GetIidFactory;
+
+    // Factories registered by UUID are reachable through their interned handle.
+    virtual EResultCode CreateObject(const IidHandle iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept = 0;
+    virtual EResultCode GetIidFactory(const IidHandle iid, ComFactoryFunc* const factory) noexcept = 0;
+
+    template<typename T>
+    // ReSharper disable once CppRedundantTypenameKeyword
+    EResultCode CreateObject(T** const pInterface, const typename T::ConstructionInfo* const pConstructionInfo) noexcept
+    {
+        return CreateObject(iid_handle_of<T>(), reinterpret_cast<void**>(pInterface), static_cast<const BaseConstructionInfo*>(pConstructionInfo));
+    }
+
+    template<typename T>
+    EResultCode CreateObject(T** const pInterface) noexcept
+    {
+        return CreateObject(iid_handle_of<T>(), reinterpret_cast<void**>(pInterface), nullptr);
+    }
+};
+
 }
 
-TAU_DECL_UUID(::tau::com::IUnknown, 0x89D0171D1E547699ull, 0x3513C89A25664A40ull);
 TAU_DECL_UUID(::tau::com::IComManager, 0xA84460A844FB841Cull, 0x8441F8C9B9F14C8Dull);
+TAU_DECL_UUID(::tau::com::IComManager::FactoriesExtension, 0x5D71B0E93A4C82F6ull, 0xF92E6C0D84B1A37Eull);
 TAU_DECL_UUID(::tau::com::IComManager1, 0x2F6E3C1FFB854DD1ull, 0x8A17434B93524BB7ull);
+TAU_DECL_UUID(::tau::com::IComManager2, 0x6C0B51E2D93A4F17ull, 0xB4E27A9C05D8E361ull);
+TAU_DECL_UUID(::tau::com::IComManager3, 0xD18F6A3C52E947B0ull, 0x7E3B0C94A1F5D628ull);
 
 extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComGetComManager(::tau::com::IComManager** const pInterface) noexcept;
@@ -1,19 +1,68 @@
 #pragma once
 
-#include "TauCOM.hpp"
+#include "TauCOM.core.hpp"
+#include "TauCOM.trace.hpp"
 #include <atomic>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #ifdef TAU_COM_USE_TAU_UTILS
 #include <allocator/TauAllocator.hpp>
 #endif
 
 #ifdef TAU_COM_USE_TAU_UTILS
+    #define TAU_COM_CREATE(T, ...) BasicTauAllocator<AllocationTracking::None>::Instance().AllocateT<T>(__VA_ARGS__)
     #define TAU_COM_DESTROY(PTR) BasicTauAllocator<AllocationTracking::None>::Instance().DeallocateT(PTR)
 #else
+    #define TAU_COM_CREATE(T, ...) new(::std::nothrow) T(__VA_ARGS__)
     #define TAU_COM_DESTROY(PTR) delete (PTR)
 #endif
 
-#define TAU_COM_IMPL_REF_COUNT() \
+// Objects constructed with ConstructInPlace only have their destructor run,
+// the storage belongs to whoever provided it.
+#define TAU_COM_IMPL_AUTO_DESTROY_NOW() \
+    private: \
+        bool m_AutoInPlace = false; \
+        void AutoDestroyNow() noexcept { \
+            [[maybe_unused]] const void* const autoTraceObject = ::tau::com::IsTraceEnabled() ? ::tau::com::TraceIdentity(this) : nullptr; \
+            TAU_COM_TRACE(::tau::com::TE_DestroyBegin, ::tau::com::UUID(), autoTraceObject); \
+            if(m_AutoInPlace) { \
+                ::std::destroy_at(this); \
+            } else { \
+                TAU_COM_DESTROY(this); \
+            } \
+            TAU_COM_TRACE(::tau::com::TE_DestroyEnd, ::tau::com::UUID(), autoTraceObject); \
+        } \
+    public: \
+        void MarkConstructedInPlace() noexcept { m_AutoInPlace = true; }
+
+#define TAU_COM_IMPL_AUTO_DESTROY() \
+    TAU_COM_IMPL_AUTO_DESTROY_NOW() \
+    private: \
+        void AutoDestroy() noexcept { AutoDestroyNow(); }
+
+// Hands the object to the background reclaimer instead of destroying it on
+// the releasing thread. In place objects are still destroyed immediately,
+// their storage may not outlive the caller's scope.
+#define TAU_COM_IMPL_DEFERRED_AUTO_DESTROY() \
+    TAU_COM_IMPL_AUTO_DESTROY_NOW() \
+    private: \
+        ::tau::com::DeferredDestroyNode m_AutoDeferredNode; \
+        void AutoDestroy() noexcept { \
+            using AutoSelf = ::std::remove_pointer_t<decltype(this)>; \
+            if(m_AutoInPlace) { \
+                AutoDestroyNow(); \
+                return; \
+            } \
+            ::tau::com::DeferDestroy(&m_AutoDeferredNode, this, [](void* const object) noexcept { \
+                static_cast<AutoSelf*>(object)->AutoDestroyNow(); \
+            }); \
+        }
+
+#define TAU_COM_IMPL_ATOMIC_REF_COUNTER() \
     private: \
         ::std::atomic<::std::int32_t> m_AutoRefCount = 1; \
     public: \
@@ -21,7 +70,475 @@
         ::std::int32_t ReleaseReference() noexcept override final { \
             const ::std::int32_t ret = m_AutoRefCount; \
             if((--m_AutoRefCount) <= 0) { \
-                TAU_COM_DESTROY(this); \
+                AutoDestroy(); \
+            } \
+            return ret; \
+        }
+
+// The count can be spread across per thread shards once
+// SwitchReferenceToSharded is called, before the object is shared. Until
+// then it behaves like TAU_COM_IMPL_ATOMIC_REF_COUNTER. Sharded counts are
+// never checked for zero, the owner has to call MarkReferenceDying before
+// dropping its own reference.
+#define TAU_COM_IMPL_SHARDED_REF_COUNTER() \
+    private: \
+        ::tau::com::ShardedRefCount m_AutoRefCount; \
+    public: \
+        ::std::int32_t AddReference() noexcept override final { return m_AutoRefCount.Increment(); } \
+        ::std::int32_t ReleaseReference() noexcept override final { \
+            const ::std::int32_t ret = m_AutoRefCount.Decrement(); \
+            if(ret <= 1) { \
+                AutoDestroy(); \
+            } \
+            return ret; \
+        } \
+        void SwitchReferenceToSharded() noexcept { m_AutoRefCount.SwitchToSharded(); } \
+        ::std::int32_t MarkReferenceDying() noexcept { \
+            const ::std::int32_t ret = m_AutoRefCount.MarkDying(); \
+            if(ret <= 0) { \
+                AutoDestroy(); \
+            } \
+            return ret; \
+        }
+
+#define TAU_COM_IMPL_REF_COUNT() \
+    TAU_COM_IMPL_AUTO_DESTROY() \
+    TAU_COM_IMPL_ATOMIC_REF_COUNTER()
+
+#define TAU_COM_IMPL_SHARDED_REF_COUNT() \
+    TAU_COM_IMPL_AUTO_DESTROY() \
+    TAU_COM_IMPL_SHARDED_REF_COUNTER()
+
+#define TAU_COM_IMPL_DEFERRED_REF_COUNT() \
+    TAU_COM_IMPL_DEFERRED_AUTO_DESTROY() \
+    TAU_COM_IMPL_ATOMIC_REF_COUNTER()
+
+#define TAU_COM_IMPL_DEFERRED_SHARDED_REF_COUNT() \
+    TAU_COM_IMPL_DEFERRED_AUTO_DESTROY() \
+    TAU_COM_IMPL_SHARDED_REF_COUNTER()
+
+// For classes implementing IAggregatable, QueryInnerInterface is left to the
+// class and plays the role QueryInterface normally would. Once given an outer
+// object every IUnknown method delegates to it, the object's own count is
+// then only dropped by ReleaseInner.
+#define TAU_COM_IMPL_AGGREGATABLE_REF_COUNT() \
+    TAU_COM_IMPL_AUTO_DESTROY() \
+    private: \
+        ::std::atomic<::std::int32_t> m_AutoRefCount = 1; \
+        ::tau::com::IUnknown* m_AutoOuter = nullptr; \
+    public: \
+        ::std::int32_t AddReference() noexcept override final { \
+            if(m_AutoOuter) { \
+                return m_AutoOuter->AddReference(); \
+            } \
+            return ++m_AutoRefCount; \
+        } \
+        ::std::int32_t ReleaseReference() noexcept override final { \
+            if(m_AutoOuter) { \
+                return m_AutoOuter->ReleaseReference(); \
+            } \
+            return ReleaseInner(); \
+        } \
+        ::tau::com::EResultCode QueryInterface(const ::tau::com::UUID& iid, void** const pInterface) noexcept override final { \
+            TAU_COM_TRACE_QUERY_INTERFACE(iid); \
+            if(m_AutoOuter) { \
+                return m_AutoOuter->QueryInterface(iid, pInterface); \
+            } \
+            return QueryInnerInterface(iid, pInterface); \
+        } \
+        ::std::int32_t ReleaseInner() noexcept override final { \
+            const ::std::int32_t ret = m_AutoRefCount; \
+            if((--m_AutoRefCount) <= 0) { \
+                AutoDestroy(); \
             } \
             return ret; \
+        } \
+        void SetOuterUnknown(::tau::com::IUnknown* const outer) noexcept { m_AutoOuter = outer; }
+
+// Implements IWeakReferenceSource, must follow TAU_COM_IMPL_REF_COUNT so the
+// anchor detaches before the count goes away.
+#define TAU_COM_IMPL_WEAK_REFERENCE_SOURCE() \
+    private: \
+        ::tau::com::WeakReferenceAnchor m_AutoWeakAnchor; \
+    public: \
+        ::tau::com::EResultCode GetWeakReference(::tau::com::IWeakReference** const pWeakReference) noexcept override { \
+            return m_AutoWeakAnchor.GetWeakReference(static_cast<::tau::com::IWeakReferenceSource*>(this), m_AutoRefCount, pWeakReference); \
         }
+
+#ifndef TAU_COM_REF_COUNT_SHARDS
+  #define TAU_COM_REF_COUNT_SHARDS 32
+#endif
+
+namespace tau::com {
+
+using DeferredDestroyFunc = void(*)(void* object) noexcept;
+
+// Embedded in deferred objects so queueing them never allocates.
+struct DeferredDestroyNode final
+{
+    DeferredDestroyNode* pNext = nullptr;
+    void* pObject = nullptr;
+    DeferredDestroyFunc Destroy = nullptr;
+};
+
+// Runs destroy immediately if the reclaimer has not been started.
+TAU_COM_LIB void DeferDestroy(DeferredDestroyNode* const node, void* const object, const DeferredDestroyFunc destroy) noexcept;
+
+[[nodiscard]] inline ::std::uint32_t CurrentRefCountShard() noexcept
+{
+    static ::std::atomic<::std::uint32_t> s_NextShard = 0;
+    thread_local const ::std::uint32_t t_Shard = s_NextShard.fetch_add(1, ::std::memory_order_relaxed) % TAU_COM_REF_COUNT_SHARDS;
+    return t_Shard;
+}
+
+/**
+ * A reference count in the style of percpu-ref.
+ *
+ * It starts out as a plain atomic count and costs no more than one. The
+ * shards are only allocated by SwitchToSharded, after which each thread
+ * only touches its own cache line. MarkDying folds the shards back into the
+ * atomic count. A shard that has been folded holds DeadValue, any update
+ * that lands on it afterwards is redirected to the atomic count.
+ *
+ * Counts are reported the way TAU_COM_IMPL_ATOMIC_REF_COUNTER does, the new
+ * count from Increment and the previous one from Decrement.
+ */
+class ShardedRefCount final
+{
+public:
+    // Returned while sharded, the real count is unknown but above zero.
+    static inline constexpr ::std::int32_t LiveCountHint = 1;
+    // Returned by Decrement while sharded, the object is still alive.
+    static inline constexpr ::std::int32_t ReleasedCountHint = LiveCountHint + 1;
+private:
+    static inline constexpr ::std::int64_t DeadValue = 1ll << 62;
+    static inline constexpr ::std::int64_t DyingBias = 1ll << 30;
+
+    struct alignas(64) Shard final
+    {
+        ::std::atomic<::std::int64_t> Value;
+    };
+public:
+    ShardedRefCount() noexcept
+        : m_Count(1)
+        , m_Shards(nullptr)
+    { }
+
+    ~ShardedRefCount() noexcept
+    {
+        delete[] m_Shards.load(::std::memory_order_relaxed);
+    }
+
+    ShardedRefCount(const ShardedRefCount& copy) noexcept = delete;
+    ShardedRefCount(ShardedRefCount&& move) noexcept = delete;
+
+    ShardedRefCount& operator=(const ShardedRefCount& copy) noexcept = delete;
+    ShardedRefCount& operator=(ShardedRefCount&& move) noexcept = delete;
+
+    ::std::int32_t Increment() noexcept
+    {
+        Shard* const shards = m_Shards.load(::std::memory_order_relaxed);
+
+        if(shards && !IsDead(shards[CurrentRefCountShard()].Value.fetch_add(1, ::std::memory_order_relaxed)))
+        {
+            return LiveCountHint;
+        }
+
+        return static_cast<::std::int32_t>(m_Count.fetch_add(1, ::std::memory_order_relaxed) + 1);
+    }
+
+    ::std::int32_t Decrement() noexcept
+    {
+        Shard* const shards = m_Shards.load(::std::memory_order_relaxed);
+
+        if(shards && !IsDead(shards[CurrentRefCountShard()].Value.fetch_sub(1, ::std::memory_order_release)))
+        {
+            return ReleasedCountHint;
+        }
+
+        return static_cast<::std::int32_t>(m_Count.fetch_sub(1, ::std::memory_order_acq_rel));
+    }
+
+    // Only valid before the object has been handed to another thread, publishing
+    // the object provides the ordering. Stays in atomic mode if the shards
+    // can't be allocated.
+    void SwitchToSharded() noexcept
+    {
+        if(m_Shards.load(::std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        Shard* const shards = new(::std::nothrow) Shard[TAU_COM_REF_COUNT_SHARDS];
+
+        if(!shards)
+        {
+            return;
+        }
+
+        for(::std::size_t i = 0; i < TAU_COM_REF_COUNT_SHARDS; ++i)
+        {
+            shards[i].Value.store(0, ::std::memory_order_relaxed);
+        }
+
+        m_Shards.store(shards, ::std::memory_order_relaxed);
+    }
+
+    // Folds the shards back into the atomic count, returning the folded count.
+    // The bias keeps concurrent releases on already folded shards from
+    // observing zero while other shards are still outstanding. The shards
+    // stay allocated until destruction, late updates may still land on them.
+    ::std::int32_t MarkDying() noexcept
+    {
+        Shard* const shards = m_Shards.load(::std::memory_order_relaxed);
+
+        if(!shards)
+        {
+            return static_cast<::std::int32_t>(m_Count.load(::std::memory_order_acquire));
+        }
+
+        m_Count.fetch_add(DyingBias, ::std::memory_order_acq_rel);
+
+        ::std::int64_t sum = 0;
+
+        for(::std::size_t i = 0; i < TAU_COM_REF_COUNT_SHARDS; ++i)
+        {
+            const ::std::int64_t value = shards[i].Value.exchange(DeadValue, ::std::memory_order_acq_rel);
+
+            if(!IsDead(value))
+            {
+                sum += value;
+            }
+        }
+
+        return static_cast<::std::int32_t>(m_Count.fetch_add(sum - DyingBias, ::std::memory_order_acq_rel) + sum - DyingBias);
+    }
+private:
+    [[nodiscard]] static bool IsDead(const ::std::int64_t value) noexcept { return value >= (DeadValue >> 1); }
+private:
+    ::std::atomic<::std::int64_t> m_Count;
+    ::std::atomic<Shard*> m_Shards;
+};
+
+template<typename T, typename... Args>
+T* ConstructInPlace(void* const pStorage, Args&&... args) noexcept
+{
+    T* const object = ::new(pStorage) T(::std::forward<Args>(args)...);
+    object->MarkConstructedInPlace();
+    return object;
+}
+
+[[nodiscard]] inline bool IsStorageSuitable(const void* const pStorage, const ::std::size_t storageSize, const ObjectLayout& layout) noexcept
+{
+    if(storageSize < layout.Size)
+    {
+        return false;
+    }
+
+    return (reinterpret_cast<::std::uintptr_t>(pStorage) & (layout.Alignment - 1)) == 0;
+}
+
+class WeakReference final : public IWeakReference
+{
+    TAU_COM_IMPL_REF_COUNT();
+public:
+    WeakReference(IUnknown* const target, ::std::atomic<::std::int32_t>* const targetRefCount) noexcept
+        : m_Target(target)
+        , m_TargetRefCount(targetRefCount)
+        , m_Resolvers(0)
+    { }
+
+    ~WeakReference() noexcept override = default;
+
+    WeakReference(const WeakReference& copy) noexcept = delete;
+    WeakReference(WeakReference&& move) noexcept = delete;
+
+    WeakReference& operator=(const WeakReference& copy) noexcept = delete;
+    WeakReference& operator=(WeakReference&& move) noexcept = delete;
+
+    EResultCode QueryInterface(const UUID& iid, void** const pInterface) noexcept override
+    {
+        TAU_COM_TRACE_QUERY_INTERFACE(iid);
+
+        if(!pInterface)
+        {
+            return RC_NullParam;
+        }
+
+        if(iid == iid_of<IUnknown> || iid == iid_of<IWeakReference>)
+        {
+            *pInterface = static_cast<IWeakReference*>(this);
+        }
+        else
+        {
+            return RC_InterfaceNotFound;
+        }
+
+        AddReference();
+        return RC_Success;
+    }
+
+    EResultCode Resolve(const UUID& iid, void** const pInterface) noexcept override
+    {
+        if(!pInterface)
+        {
+            return RC_NullParam;
+        }
+
+        // While we are registered as a resolver Detach can't return, so the
+        // target's memory stays valid even if its count has already hit zero.
+        m_Resolvers.fetch_add(1, ::std::memory_order_seq_cst);
+
+        IUnknown* const target = m_Target.load(::std::memory_order_seq_cst);
+        bool acquired = false;
+
+        if(target)
+        {
+            ::std::int32_t count = m_TargetRefCount->load(::std::memory_order_relaxed);
+            while(count > 0)
+            {
+                if(m_TargetRefCount->compare_exchange_weak(count, count + 1, ::std::memory_order_acquire, ::std::memory_order_relaxed))
+                {
+                    acquired = true;
+                    break;
+                }
+            }
+        }
+
+        m_Resolvers.fetch_sub(1, ::std::memory_order_release);
+
+        if(!acquired)
+        {
+            *pInterface = nullptr;
+            return RC_NotReady;
+        }
+
+        const EResultCode result = target->QueryInterface(iid, pInterface);
+        (void) target->ReleaseReference();
+        return result;
+    }
+
+    // Called from the target's destructor.
+    void Detach() noexcept
+    {
+        m_Target.store(nullptr, ::std::memory_order_seq_cst);
+
+        while(m_Resolvers.load(::std::memory_order_acquire) != 0)
+        { }
+    }
+private:
+    ::std::atomic<IUnknown*> m_Target;
+    ::std::atomic<::std::int32_t>* m_TargetRefCount;
+    ::std::atomic<::std::uint32_t> m_Resolvers;
+};
+
+class WeakReferenceAnchor final
+{
+public:
+    WeakReferenceAnchor() noexcept
+        : m_Reference(nullptr)
+    { }
+
+    ~WeakReferenceAnchor() noexcept
+    {
+        WeakReference* const reference = m_Reference.load(::std::memory_order_acquire);
+
+        if(reference)
+        {
+            reference->Detach();
+            (void) reference->ReleaseReference();
+        }
+    }
+
+    WeakReferenceAnchor(const WeakReferenceAnchor& copy) noexcept = delete;
+    WeakReferenceAnchor(WeakReferenceAnchor&& move) noexcept = delete;
+
+    WeakReferenceAnchor& operator=(const WeakReferenceAnchor& copy) noexcept = delete;
+    WeakReferenceAnchor& operator=(WeakReferenceAnchor&& move) noexcept = delete;
+
+    EResultCode GetWeakReference(IUnknown* const target, ::std::atomic<::std::int32_t>& targetRefCount, IWeakReference** const pWeakReference) noexcept
+    {
+        if(!pWeakReference)
+        {
+            return RC_NullParam;
+        }
+
+        WeakReference* reference = m_Reference.load(::std::memory_order_acquire);
+
+        if(!reference)
+        {
+            WeakReference* const created = TAU_COM_CREATE(WeakReference, target, &targetRefCount);
+
+            if(!created)
+            {
+                *pWeakReference = nullptr;
+                return RC_OutOfMemory;
+            }
+
+            if(m_Reference.compare_exchange_strong(reference, created, ::std::memory_order_acq_rel, ::std::memory_order_acquire))
+            {
+                reference = created;
+            }
+            else
+            {
+                (void) created->ReleaseReference();
+            }
+        }
+
+        (void) reference->AddReference();
+        *pWeakReference = reference;
+        return RC_Success;
+    }
+private:
+    ::std::atomic<WeakReference*> m_Reference;
+};
+
+/**
+ * Lays aggregatable inner objects out inside the outer object, so the whole
+ * composite is a single allocation with a single reference count. The outer
+ * object answers IUnknown itself and forwards anything else it doesn't
+ * implement to QueryInnerInterface.
+ */
+template<typename... TInner>
+class InlineAggregate final
+{
+public:
+    explicit InlineAggregate(IUnknown* const outer) noexcept
+        : m_Inner()
+    {
+        ::std::apply([outer](TInner&... inner) { (inner.SetOuterUnknown(outer), ...); }, m_Inner);
+    }
+
+    ~InlineAggregate() noexcept = default;
+
+    InlineAggregate(const InlineAggregate& copy) noexcept = delete;
+    InlineAggregate(InlineAggregate&& move) noexcept = delete;
+
+    InlineAggregate& operator=(const InlineAggregate& copy) noexcept = delete;
+    InlineAggregate& operator=(InlineAggregate&& move) noexcept = delete;
+
+    EResultCode QueryInnerInterface(const UUID& iid, void** const pInterface) noexcept
+    {
+        // Inline objects are never released on their own.
+        if(iid == iid_of<IAggregatable>)
+        {
+            return RC_InterfaceNotFound;
+        }
+
+        EResultCode result = RC_InterfaceNotFound;
+
+        ::std::apply([&](TInner&... inner)
+        {
+            (void) (IsSuccess(result = inner.QueryInnerInterface(iid, pInterface)) || ...);
+        }, m_Inner);
+
+        return result;
+    }
+
+    template<typename T>
+    [[nodiscard]] T& Get() noexcept { return ::std::get<T>(m_Inner); }
+private:
+    ::std::tuple<TInner...> m_Inner;
+};
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "TauCOM.core.hpp"
+#include <atomic>
+
+namespace tau::com {
+
+enum ETraceEvent : ::std::uint32_t
+{
+    TE_FactoryBegin = 0,
+    TE_FactoryEnd,
+    TE_Construct,
+    TE_DestroyBegin,
+    TE_DestroyEnd,
+    TE_QueryInterface,
+};
+
+enum ETraceFormat : ::std::uint32_t
+{
+    // Trace event JSON, loads in chrome://tracing and Perfetto.
+    TF_ChromeJson = 0,
+    // The line format of `perf script`.
+    TF_PerfScript,
+};
+
+extern TAU_COM_LIB ::std::atomic<bool> g_TraceEnabled;
+
+[[nodiscard]] inline bool IsTraceEnabled() noexcept
+{
+    return g_TraceEnabled.load(::std::memory_order_relaxed);
+}
+
+/**
+ * The address of the complete object, so records made through any of its
+ * interfaces, or from its own destructor, name the same object. GCC and
+ * Clang read it from the vtable even without RTTI, MSVC needs /GR.
+ */
+template<typename T>
+[[nodiscard]] inline const void* TraceIdentity(const T* const object) noexcept
+{
+#if defined(_MSC_VER) && !defined(_CPPRTTI)
+    return object;
+#else
+    return dynamic_cast<const void*>(object);
+#endif
+}
+
+TAU_COM_LIB void TraceRecord(const ETraceEvent event, const UUID& iid, const void* const pObject) noexcept;
+
+}
+
+#ifdef TAU_COM_DISABLE_TRACING
+  #define TAU_COM_TRACE(EVENT, IID, OBJECT) do { } while(0)
+#else
+  #define TAU_COM_TRACE(EVENT, IID, OBJECT) \
+      do { \
+          if(::tau::com::IsTraceEnabled()) [[unlikely]] { \
+              ::tau::com::TraceRecord((EVENT), (IID), (OBJECT)); \
+          } \
+      } while(0)
+#endif
+
+// For use at the top of QueryInterface implementations.
+#define TAU_COM_TRACE_QUERY_INTERFACE(IID) TAU_COM_TRACE(::tau::com::TE_QueryInterface, (IID), ::tau::com::TraceIdentity(this))
+
+extern "C" TAU_COM_LIB void TauComTraceSetEnabled(const bool enabled) noexcept;
+/**
+ * Drains every thread's trace buffer into the file at path. Records
+ * written concurrently with the flush may be left for the next one.
+ */
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComTraceFlush(const char* const path, const ::tau::com::ETraceFormat format) noexcept;
@@ -0,0 +1,552 @@
+#include "EventHub.hpp"
+#include <algorithm>
+
+namespace tau::com {
+
+EventHub::EventHub() noexcept
+    : m_Snapshot(nullptr)
+    , m_Epoch(0)
+    , m_Publishers { 0, 0 }
+    , m_HasRetired(false)
+    , m_WriteLock()
+    , m_Retired(nullptr)
+    , m_CookieTopics()
+    , m_NextCookie(1)
+{ }
+
+EventHub::~EventHub() noexcept
+{
+    Snapshot* const snapshot = m_Snapshot.load(::std::memory_order_acquire);
+
+    if(snapshot)
+    {
+        for(const Topic& topic : snapshot->Topics)
+        {
+            TAU_COM_DESTROY(topic.Subscribers);
+        }
+    }
+
+    FreeSnapshots(snapshot);
+    FreeSnapshots(m_Retired);
+}
+
+EResultCode EventHub::QueryInnerInterface(const UUID& iid, void** const pInterface) noexcept
+{
+    if(!pInterface)
+    {
+        return RC_NullParam;
+    }
+
+    if(iid == iid_of<IUnknown> || iid == iid_of<IEventHub>)
+    {
+        *pInterface = static_cast<IEventHub*>(this);
+    }
+    else if(iid == iid_of<IAggregatable>)
+    {
+        *pInterface = static_cast<IAggregatable*>(this);
+    }
+    else
+    {
+        return RC_InterfaceNotFound;
+    }
+
+    AddReference();
+    return RC_Success;
+}
+
+EResultCode EventHub::Subscribe(const UUID& topic, IEventSink* const pSink, const ESubscribeFlags flags, ::std::uint64_t* const pCookie) noexcept
+{
+    if(!pSink || !pCookie)
+    {
+        return RC_NullParam;
+    }
+
+    Subscriber subscriber { topic, 0, nullptr, nullptr };
+
+    if(flags & SF_Weak)
+    {
+        ComRef<IWeakReferenceSource> weakSource;
+        const EResultCode result = pSink->QueryInterface<IWeakReferenceSource>(weakSource.Load());
+
+        if(IsFailure(result))
+        {
+            return result;
+        }
+
+        const EResultCode weakResult = weakSource->GetWeakReference(subscriber.WeakSink.Load());
+
+        if(IsFailure(weakResult))
+        {
+            return weakResult;
+        }
+    }
+    else
+    {
+        (void) pSink->AddReference();
+        subscriber.Sink = pSink;
+    }
+
+    Snapshot* retired;
+
+    {
+        ::std::lock_guard lock(m_WriteLock);
+
+        TopicSubscribers* const subscribers = TAU_COM_CREATE(TopicSubscribers);
+
+        if(!subscribers)
+        {
+            return RC_OutOfMemory;
+        }
+
+        if(const TopicSubscribers* const current = FindTopic(topic))
+        {
+            subscribers->Subscribers.reserve(current->Subscribers.size() + 1);
+            subscribers->Subscribers = current->Subscribers;
+        }
+
+        const ::std::uint64_t cookie = m_NextCookie++;
+        subscriber.Cookie = cookie;
+        subscribers->Subscribers.push_back(::std::move(subscriber));
+
+        const EResultCode result = ReplaceTopic(topic, subscribers);
+
+        if(IsFailure(result))
+        {
+            return result;
+        }
+
+        m_CookieTopics.emplace(cookie, topic);
+        *pCookie = cookie;
+        retired = TakeReclaimable();
+    }
+
+    // Releasing sinks may re-enter the hub, so this happens outside the lock.
+    FreeSnapshots(retired);
+
+    return RC_Success;
+}
+
+EResultCode EventHub::Unsubscribe(const ::std::uint64_t cookie) noexcept
+{
+    Snapshot* retired;
+
+    {
+        ::std::lock_guard lock(m_WriteLock);
+
+        const auto cookieTopic = m_CookieTopics.find(cookie);
+
+        if(cookieTopic == m_CookieTopics.end())
+        {
+            return RC_InvalidParam;
+        }
+
+        const UUID topic = cookieTopic->second;
+        const TopicSubscribers* const current = FindTopic(topic);
+        TopicSubscribers* subscribers = nullptr;
+
+        if(current->Subscribers.size() > 1)
+        {
+            subscribers = TAU_COM_CREATE(TopicSubscribers);
+
+            if(!subscribers)
+            {
+                return RC_OutOfMemory;
+            }
+
+            subscribers->Subscribers.reserve(current->Subscribers.size() - 1);
+
+            for(const Subscriber& subscriber : current->Subscribers)
+            {
+                if(subscriber.Cookie != cookie)
+                {
+                    subscribers->Subscribers.push_back(subscriber);
+                }
+            }
+        }
+
+        const EResultCode result = ReplaceTopic(topic, subscribers);
+
+        if(IsFailure(result))
+        {
+            return result;
+        }
+
+        m_CookieTopics.erase(cookieTopic);
+        retired = TakeReclaimable();
+    }
+
+    FreeSnapshots(retired);
+
+    return RC_Success;
+}
+
+EResultCode EventHub::Publish(const UUID& topic, const Event* const pEvents, const ::std::size_t eventCount) noexcept
+{
+    if(!pEvents && eventCount != 0)
+    {
+        return RC_NullParam;
+    }
+
+    const ::std::uint32_t slot = EnterPublish();
+
+    const Snapshot* const snapshot = m_Snapshot.load(::std::memory_order_seq_cst);
+    bool foundDead = false;
+
+    if(snapshot)
+    {
+        const auto it = ::std::lower_bound(snapshot->Topics.begin(), snapshot->Topics.end(), topic, TopicLess);
+
+        if(it != snapshot->Topics.end() && it->Id == topic)
+        {
+            for(const Subscriber& subscriber : it->Subscribers->Subscribers)
+            {
+                if(subscriber.WeakSink)
+                {
+                    ComRef<IEventSink> sink;
+
+                    if(IsSuccess(subscriber.WeakSink->Resolve<IEventSink>(sink.Load())))
+                    {
+                        sink->OnEvents(topic, pEvents, eventCount);
+                    }
+                    else
+                    {
+                        foundDead = true;
+                    }
+                }
+                else
+                {
+                    subscriber.Sink->OnEvents(topic, pEvents, eventCount);
+                }
+            }
+        }
+    }
+
+    LeavePublish(slot);
+
+    if(m_HasRetired.load(::std::memory_order_seq_cst))
+    {
+        TryReclaim();
+    }
+
+    if(foundDead)
+    {
+        PruneDeadSubscribers(topic);
+    }
+
+    return RC_Success;
+}
+
+::std::uint32_t EventHub::EnterPublish() noexcept
+{
+    for(;;)
+    {
+        const ::std::uint64_t epoch = m_Epoch.load(::std::memory_order_seq_cst);
+        const ::std::uint32_t slot = static_cast<::std::uint32_t>(epoch & 1);
+
+        m_Publishers[slot].fetch_add(1, ::std::memory_order_seq_cst);
+
+        // If the epoch moved on the writer may already have checked this slot.
+        if(m_Epoch.load(::std::memory_order_seq_cst) == epoch)
+        {
+            return slot;
+        }
+
+        m_Publishers[slot].fetch_sub(1, ::std::memory_order_seq_cst);
+    }
+}
+
+void EventHub::LeavePublish(const ::std::uint32_t slot) noexcept
+{
+    m_Publishers[slot].fetch_sub(1, ::std::memory_order_seq_cst);
+}
+
+const EventHub::TopicSubscribers* EventHub::FindTopic(const UUID& topic) const noexcept
+{
+    const Snapshot* const snapshot = m_Snapshot.load(::std::memory_order_relaxed);
+
+    if(!snapshot)
+    {
+        return nullptr;
+    }
+
+    const auto it = ::std::lower_bound(snapshot->Topics.begin(), snapshot->Topics.end(), topic, TopicLess);
+    return it != snapshot->Topics.end() && it->Id == topic ? it->Subscribers : nullptr;
+}
+
+EResultCode EventHub::ReplaceTopic(const UUID& topic, TopicSubscribers* const subscribers) noexcept
+{
+    Snapshot* const snapshot = TAU_COM_CREATE(Snapshot);
+
+    if(!snapshot)
+    {
+        if(subscribers)
+        {
+            TAU_COM_DESTROY(subscribers);
+        }
+
+        return RC_OutOfMemory;
+    }
+
+    // Only pointers are copied, the lists of other topics are shared.
+    if(const Snapshot* const current = m_Snapshot.load(::std::memory_order_relaxed))
+    {
+        snapshot->Topics.reserve(current->Topics.size() + 1);
+        snapshot->Topics = current->Topics;
+    }
+
+    TopicSubscribers* replaced = nullptr;
+    const auto it = ::std::lower_bound(snapshot->Topics.begin(), snapshot->Topics.end(), topic, TopicLess);
+
+    if(it != snapshot->Topics.end() && it->Id == topic)
+    {
+        replaced = it->Subscribers;
+
+        if(subscribers)
+        {
+            it->Subscribers = subscribers;
+        }
+        else
+        {
+            snapshot->Topics.erase(it);
+        }
+    }
+    else if(subscribers)
+    {
+        snapshot->Topics.insert(it, Topic { topic, subscribers });
+    }
+
+    Snapshot* const old = m_Snapshot.exchange(snapshot, ::std::memory_order_seq_cst);
+
+    if(old)
+    {
+        // The replaced list is only reachable through snapshots that are at
+        // least as old, so it shares the retirement of this one.
+        old->RetiredSubscribers = replaced;
+        old->RetiredEpoch = m_Epoch.load(::std::memory_order_relaxed);
+        old->pNextRetired = m_Retired;
+        m_Retired = old;
+        m_HasRetired.store(true, ::std::memory_order_seq_cst);
+    }
+
+    return RC_Success;
+}
+
+void EventHub::TryAdvanceEpoch() noexcept
+{
+    // Only the lock holder writes the epoch. Moving from E to E + 1 reuses the
+    // slot of E - 1, which must have drained first.
+    for(int i = 0; i < 2; ++i)
+    {
+        const ::std::uint64_t epoch = m_Epoch.load(::std::memory_order_relaxed);
+
+        if(m_Publishers[(epoch + 1) & 1].load(::std::memory_order_seq_cst) != 0)
+        {
+            return;
+        }
+
+        m_Epoch.store(epoch + 1, ::std::memory_order_seq_cst);
+    }
+}
+
+EventHub::Snapshot* EventHub::TakeReclaimable() noexcept
+{
+    if(!m_Retired)
+    {
+        return nullptr;
+    }
+
+    TryAdvanceEpoch();
+
+    const ::std::uint64_t epoch = m_Epoch.load(::std::memory_order_relaxed);
+
+    // The list is newest first, everything after the first reclaimable entry
+    // was retired earlier and is reclaimable too.
+    Snapshot** link = &m_Retired;
+    while(*link && (*link)->RetiredEpoch + 2 > epoch)
+    {
+        link = &(*link)->pNextRetired;
+    }
+
+    Snapshot* const retired = *link;
+    *link = nullptr;
+
+    m_HasRetired.store(m_Retired != nullptr, ::std::memory_order_seq_cst);
+    return retired;
+}
+
+void EventHub::PruneDeadSubscribers(const UUID& topic) noexcept
+{
+    Snapshot* retired;
+
+    {
+        // Publishing must never block, if another thread is already changing
+        // subscriptions the dead entries will be pruned by a later publish.
+        ::std::unique_lock lock(m_WriteLock, ::std::try_to_lock);
+
+        if(!lock)
+        {
+            return;
+        }
+
+        const TopicSubscribers* const current = FindTopic(topic);
+
+        if(!current)
+        {
+            return;
+        }
+
+        TopicSubscribers* subscribers = TAU_COM_CREATE(TopicSubscribers);
+
+        if(!subscribers)
+        {
+            return;
+        }
+
+        subscribers->Subscribers.reserve(current->Subscribers.size());
+
+        for(const Subscriber& subscriber : current->Subscribers)
+        {
+            if(subscriber.WeakSink)
+            {
+                ComRef<IUnknown> alive;
+
+                if(IsFailure(subscriber.WeakSink->Resolve<IUnknown>(alive.Load())))
+                {
+                    continue;
+                }
+            }
+
+            subscribers->Subscribers.push_back(subscriber);
+        }
+
+        if(subscribers->Subscribers.size() == current->Subscribers.size())
+        {
+            TAU_COM_DESTROY(subscribers);
+            return;
+        }
+
+        if(subscribers->Subscribers.empty())
+        {
+            TAU_COM_DESTROY(subscribers);
+            subscribers = nullptr;
+        }
+
+        if(IsFailure(ReplaceTopic(topic, subscribers)))
+        {
+            return;
+        }
+
+        // The kept entries are in their original order, everything else was
+        // pruned. The old list stays alive until TakeReclaimable hands it out.
+        ::std::size_t kept = 0;
+        for(const Subscriber& subscriber : current->Subscribers)
+        {
+            if(subscribers && kept < subscribers->Subscribers.size() && subscribers->Subscribers[kept].Cookie == subscriber.Cookie)
+            {
+                ++kept;
+            }
+            else
+            {
+                (void) m_CookieTopics.erase(subscriber.Cookie);
+            }
+        }
+
+        retired = TakeReclaimable();
+    }
+
+    FreeSnapshots(retired);
+}
+
+void EventHub::TryReclaim() noexcept
+{
+    Snapshot* retired;
+
+    {
+        ::std::unique_lock lock(m_WriteLock, ::std::try_to_lock);
+
+        if(!lock)
+        {
+            return;
+        }
+
+        retired = TakeReclaimable();
+    }
+
+    FreeSnapshots(retired);
+}
+
+void* EventHub::Attach(const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    if(const AggregationInfo* const aggregationInfo = FindConstructionInfo<AggregationInfo>(pConstructionInfo))
+    {
+        aggregationInfo->Accept();
+        SetOuterUnknown(aggregationInfo->pOuter);
+        return static_cast<IAggregatable*>(this);
+    }
+
+    return static_cast<IEventHub*>(this);
+}
+
+bool EventHub::TopicLess(const Topic& topic, const UUID& id) noexcept
+{
+    return topic.Id.High < id.High || (topic.Id.High == id.High && topic.Id.Low < id.Low);
+}
+
+void EventHub::FreeSnapshots(Snapshot* snapshot) noexcept
+{
+    while(snapshot)
+    {
+        Snapshot* const next = snapshot->pNextRetired;
+
+        if(snapshot->RetiredSubscribers)
+        {
+            TAU_COM_DESTROY(snapshot->RetiredSubscribers);
+        }
+
+        TAU_COM_DESTROY(snapshot);
+        snapshot = next;
+    }
+}
+
+EResultCode EventHub::Factory(const UUID& iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    if(!pInterface)
+    {
+        return RC_NullParam;
+    }
+
+    if(iid != iid_of<IEventHub>)
+    {
+        return RC_InterfaceNotFound;
+    }
+
+    EventHub* const eventHub = TAU_COM_CREATE(EventHub);
+
+    if(!eventHub)
+    {
+        return RC_OutOfMemory;
+    }
+
+    *pInterface = eventHub->Attach(pConstructionInfo);
+
+    return RC_Success;
+}
+
+EResultCode EventHub::PlacementFactory(const UUID& iid, void* const pStorage, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    if(!pStorage || !pInterface)
+    {
+        return RC_NullParam;
+    }
+
+    if(iid != iid_of<IEventHub>)
+    {
+        return RC_InterfaceNotFound;
+    }
+
+    *pInterface = ConstructInPlace<EventHub>(pStorage)->Attach(pConstructionInfo);
+
+    return RC_Success;
+}
+
+}
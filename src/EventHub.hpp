@@ -0,0 +1,107 @@
+#pragma once
+
+#include "TauCOM.hpp"
+#include "TauCOM.impl.hpp"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tau::com {
+
+/**
+ * Subscribers live in immutable per topic lists, indexed by an immutable
+ * snapshot sorted by topic. A subscription change copies the index and the
+ * one list it touches, lists of other topics are shared with the previous
+ * snapshot. Publish only ever reads an atomic pointer and walks the
+ * subscribers of its own topic.
+ *
+ * Replaced snapshots are reclaimed with a two phase epoch. Publishers count
+ * themselves in the reader slot of the epoch they started in. The epoch
+ * only advances once the slot it is about to reuse has drained, so a
+ * snapshot retired in epoch E can't be referenced once the epoch reaches
+ * E + 2. Publishers that keep overlapping never hold up reclamation, only a
+ * single publish that outlives two advances does.
+ */
+class EventHub final : public IEventHub, public IAggregatable
+{
+    TAU_COM_IMPL_AGGREGATABLE_REF_COUNT();
+private:
+    struct Subscriber final
+    {
+        UUID Topic;
+        ::std::uint64_t Cookie;
+        ComRef<IEventSink> Sink;
+        ComRef<IWeakReference> WeakSink;
+    };
+
+    struct TopicSubscribers final
+    {
+        ::std::vector<Subscriber> Subscribers;
+    };
+
+    struct Topic final
+    {
+        UUID Id;
+        TopicSubscribers* Subscribers;
+    };
+
+    struct Snapshot final
+    {
+        // Sorted by Id. The lists are owned by the live snapshot, a retired
+        // snapshot only owns the list its replacement dropped.
+        ::std::vector<Topic> Topics;
+        Snapshot* pNextRetired = nullptr;
+        TopicSubscribers* RetiredSubscribers = nullptr;
+        ::std::uint64_t RetiredEpoch = 0;
+    };
+public:
+    EventHub() noexcept;
+    ~EventHub() noexcept override;
+
+    EventHub(const EventHub& copy) noexcept = delete;
+    EventHub(EventHub&& move) noexcept = delete;
+    EventHub& operator=(const EventHub& copy) noexcept = delete;
+    EventHub& operator=(EventHub&& move) noexcept = delete;
+
+    // IAggregatable
+    EResultCode QueryInnerInterface(const UUID& iid, void** const pInterface) noexcept override;
+
+    // IEventHub
+    EResultCode Subscribe(const UUID& topic, IEventSink* const pSink, const ESubscribeFlags flags, ::std::uint64_t* const pCookie) noexcept override;
+    EResultCode Unsubscribe(const ::std::uint64_t cookie) noexcept override;
+    EResultCode Publish(const UUID& topic, const Event* const pEvents, const ::std::size_t eventCount) noexcept override;
+public:
+    static EResultCode Factory(const UUID& iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept;
+    static EResultCode PlacementFactory(const UUID& iid, void* const pStorage, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept;
+private:
+    // Returns the pointer a factory hands out, aggregated or not.
+    [[nodiscard]] void* Attach(const BaseConstructionInfo* const pConstructionInfo) noexcept;
+
+    // Returns the reader slot to leave once the snapshot is no longer used.
+    [[nodiscard]] ::std::uint32_t EnterPublish() noexcept;
+    void LeavePublish(const ::std::uint32_t slot) noexcept;
+
+    // These all require m_WriteLock to be held.
+    [[nodiscard]] const TopicSubscribers* FindTopic(const UUID& topic) const noexcept;
+    // Takes ownership of subscribers, null removes the topic.
+    [[nodiscard]] EResultCode ReplaceTopic(const UUID& topic, TopicSubscribers* const subscribers) noexcept;
+    void TryAdvanceEpoch() noexcept;
+    [[nodiscard]] Snapshot* TakeReclaimable() noexcept;
+
+    void PruneDeadSubscribers(const UUID& topic) noexcept;
+    void TryReclaim() noexcept;
+
+    [[nodiscard]] static bool TopicLess(const Topic& topic, const UUID& id) noexcept;
+    static void FreeSnapshots(Snapshot* snapshot) noexcept;
+private:
+    ::std::atomic<Snapshot*> m_Snapshot;
+    ::std::atomic<::std::uint64_t> m_Epoch;
+    ::std::atomic<::std::uint32_t> m_Publishers[2];
+    ::std::atomic<bool> m_HasRetired;
+    ::std::mutex m_WriteLock;
+    Snapshot* m_Retired;
+    ::std::unordered_map<::std::uint64_t, UUID> m_CookieTopics;
+    ::std::uint64_t m_NextCookie;
+};
+
+}
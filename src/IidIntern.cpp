@@ -0,0 +1,131 @@
+#include "TauCOM.hpp"
+#include "TauCOM.impl.hpp"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace tau::com {
+
+/**
+ * Handles index into fixed size chunks that are never moved or freed, so
+ * resolving a handle back to its UUID needs no lock. Only interning a new
+ * UUID takes the writer side of the table lock.
+ */
+static constexpr ::std::uint32_t InternChunkShift = 10;
+static constexpr ::std::uint32_t InternChunkSize = 1u << InternChunkShift;
+static constexpr ::std::uint32_t InternChunkCount = 256;
+
+// Constant initialized, so safe to use from other static initializers.
+static ::std::atomic<UUID*> s_InternChunks[InternChunkCount] { };
+static ::std::atomic<::std::uint32_t> s_InternCount = 0;
+
+struct InternTable final
+{
+    ::std::shared_mutex Lock;
+    ::std::unordered_map<UUID, IidHandle> Handles;
+};
+
+// Created on first use and never destroyed, like the global ComManager, so
+// interning works from static initializers and destructors alike.
+[[nodiscard]] static InternTable* GetInternTable() noexcept
+{
+    static InternTable* const s_InternTable = new(::std::nothrow) InternTable;
+    return s_InternTable;
+}
+
+}
+
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComInternIid(const ::tau::com::UUID& iid, ::tau::com::IidHandle* const pHandle) noexcept
+{
+    using namespace tau::com;
+
+    if(!pHandle)
+    {
+        return RC_NullParam;
+    }
+
+    InternTable* const table = GetInternTable();
+
+    if(!table)
+    {
+        *pHandle = IidHandle::Invalid;
+        return RC_OutOfMemory;
+    }
+
+    {
+        ::std::shared_lock lock(table->Lock);
+
+        const auto it = table->Handles.find(iid);
+
+        if(it != table->Handles.end())
+        {
+            *pHandle = it->second;
+            return RC_Success;
+        }
+    }
+
+    ::std::unique_lock lock(table->Lock);
+
+    const auto it = table->Handles.find(iid);
+
+    if(it != table->Handles.end())
+    {
+        *pHandle = it->second;
+        return RC_Success;
+    }
+
+    const ::std::uint32_t index = s_InternCount.load(::std::memory_order_relaxed);
+    const ::std::uint32_t chunkIndex = index >> InternChunkShift;
+
+    if(chunkIndex >= InternChunkCount)
+    {
+        *pHandle = IidHandle::Invalid;
+        return RC_OutOfMemory;
+    }
+
+    UUID* chunk = s_InternChunks[chunkIndex].load(::std::memory_order_relaxed);
+
+    if(!chunk)
+    {
+        // Chunks live for the rest of the process.
+        chunk = new(::std::nothrow) UUID[InternChunkSize];
+
+        if(!chunk)
+        {
+            *pHandle = IidHandle::Invalid;
+            return RC_OutOfMemory;
+        }
+
+        s_InternChunks[chunkIndex].store(chunk, ::std::memory_order_release);
+    }
+
+    chunk[index & (InternChunkSize - 1)] = iid;
+    s_InternCount.store(index + 1, ::std::memory_order_release);
+
+    const IidHandle handle = static_cast<IidHandle>(index);
+    table->Handles[iid] = handle;
+    *pHandle = handle;
+
+    return RC_Success;
+}
+
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComGetInternedIid(const ::tau::com::IidHandle handle, ::tau::com::UUID* const pIid) noexcept
+{
+    using namespace tau::com;
+
+    if(!pIid)
+    {
+        return RC_NullParam;
+    }
+
+    const ::std::uint32_t index = static_cast<::std::uint32_t>(handle);
+
+    if(index >= s_InternCount.load(::std::memory_order_acquire))
+    {
+        return RC_InvalidParam;
+    }
+
+    *pIid = s_InternChunks[index >> InternChunkShift].load(::std::memory_order_acquire)[index & (InternChunkSize - 1)];
+
+    return RC_Success;
+}
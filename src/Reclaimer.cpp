@@ -0,0 +1,277 @@
+#include "TauCOM.hpp"
+#include "TauCOM.impl.hpp"
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace tau::com {
+
+// Pushed to by any releasing thread, emptied wholesale by whoever drains.
+static ::std::atomic<DeferredDestroyNode*> s_Pending = nullptr;
+// Bumped when s_Pending goes from empty to non-empty, the reclaimer waits on it.
+static ::std::atomic<::std::uint32_t> s_PendingSignal = 0;
+static ::std::atomic<bool> s_ReclaimerRunning = false;
+// Bumped by every start and stop, a reclaimer thread only runs while it
+// matches the value it was started with.
+static ::std::atomic<::std::uint64_t> s_ReclaimerGeneration = 0;
+// Threads between checking s_ReclaimerRunning and finishing their push.
+static ::std::atomic<::std::uint32_t> s_Deferring = 0;
+// Batches detached from s_Pending that are still being destroyed.
+static ::std::atomic<::std::uint32_t> s_InFlight = 0;
+static ::std::mutex s_ReclaimerControlLock;
+static ::std::thread s_ReclaimerThread;
+// A reclaimer that stopped itself from a deferred destructor, it exits after
+// its current batch and is joined by the next start or stop from elsewhere.
+static ::std::thread s_RetiredReclaimerThread;
+static bool s_ExitHookRegistered = false;
+// Set while this thread runs deferred destructors. A drain from inside one
+// can't wait for the batch it is itself part of.
+static thread_local bool t_InDeferredDestroy = false;
+
+static bool DrainOnce() noexcept
+{
+    s_InFlight.fetch_add(1, ::std::memory_order_acq_rel);
+
+    DeferredDestroyNode* node = s_Pending.exchange(nullptr, ::std::memory_order_acquire);
+    const bool drained = node != nullptr;
+
+    // The list is LIFO, reverse it so objects die in the order they were released.
+    DeferredDestroyNode* ordered = nullptr;
+    while(node)
+    {
+        DeferredDestroyNode* const next = node->pNext;
+        node->pNext = ordered;
+        ordered = node;
+        node = next;
+    }
+
+    const bool nested = t_InDeferredDestroy;
+    t_InDeferredDestroy = true;
+
+    while(ordered)
+    {
+        // The node lives inside the object, read it before destroying.
+        DeferredDestroyNode* const next = ordered->pNext;
+        ordered->Destroy(ordered->pObject);
+        ordered = next;
+    }
+
+    t_InDeferredDestroy = nested;
+
+    if(s_InFlight.fetch_sub(1, ::std::memory_order_acq_rel) == 1)
+    {
+        s_InFlight.notify_all();
+    }
+
+    return drained;
+}
+
+static void ReclaimerMain(const ::std::uint64_t generation) noexcept
+{
+    while(true)
+    {
+        const ::std::uint32_t signal = s_PendingSignal.load(::std::memory_order_acquire);
+
+        (void) DrainOnce();
+
+        if(s_ReclaimerGeneration.load(::std::memory_order_acquire) != generation)
+        {
+            return;
+        }
+
+        if(!s_Pending.load(::std::memory_order_acquire))
+        {
+            s_PendingSignal.wait(signal, ::std::memory_order_acquire);
+        }
+    }
+}
+
+// Requires s_ReclaimerControlLock. Returns the retired reclaimer for the
+// caller to join outside the lock, unless that would be joining itself.
+static ::std::thread TakeRetiredReclaimer() noexcept
+{
+    if(!s_RetiredReclaimerThread.joinable() || s_RetiredReclaimerThread.get_id() == ::std::this_thread::get_id())
+    {
+        return { };
+    }
+
+    return ::std::move(s_RetiredReclaimerThread);
+}
+
+// Exiting with a joinable std::thread terminates the process. The hook runs
+// before the destructors of statics constructed before the reclaimer was
+// started, so anything deferred objects depend on is still alive.
+static void StopReclaimerAtExit() noexcept
+{
+    (void) TauComStopReclaimer();
+
+    ::std::thread retired;
+
+    {
+        ::std::lock_guard lock(s_ReclaimerControlLock);
+        retired = TakeRetiredReclaimer();
+
+        // Only left behind if a deferred destructor called exit itself.
+        if(s_RetiredReclaimerThread.joinable())
+        {
+            s_RetiredReclaimerThread.detach();
+        }
+    }
+
+    if(retired.joinable())
+    {
+        retired.join();
+    }
+}
+
+TAU_COM_LIB void DeferDestroy(DeferredDestroyNode* const node, void* const object, const DeferredDestroyFunc destroy) noexcept
+{
+    s_Deferring.fetch_add(1, ::std::memory_order_seq_cst);
+
+    if(!s_ReclaimerRunning.load(::std::memory_order_seq_cst))
+    {
+        s_Deferring.fetch_sub(1, ::std::memory_order_release);
+        destroy(object);
+        return;
+    }
+
+    node->pObject = object;
+    node->Destroy = destroy;
+
+    DeferredDestroyNode* head = s_Pending.load(::std::memory_order_relaxed);
+    do
+    {
+        node->pNext = head;
+    } while(!s_Pending.compare_exchange_weak(head, node, ::std::memory_order_release, ::std::memory_order_relaxed));
+
+    if(!head)
+    {
+        s_PendingSignal.fetch_add(1, ::std::memory_order_release);
+        s_PendingSignal.notify_one();
+    }
+
+    s_Deferring.fetch_sub(1, ::std::memory_order_release);
+}
+
+}
+
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComStartReclaimer() noexcept
+{
+    using namespace tau::com;
+
+    ::std::thread retired;
+
+    {
+        ::std::lock_guard lock(s_ReclaimerControlLock);
+
+        if(s_ReclaimerRunning.load(::std::memory_order_relaxed))
+        {
+            return RC_Success;
+        }
+
+        if(!s_ExitHookRegistered)
+        {
+            if(::std::atexit(StopReclaimerAtExit) != 0)
+            {
+                return RC_Fail;
+            }
+
+            s_ExitHookRegistered = true;
+        }
+
+        retired = TakeRetiredReclaimer();
+
+        const ::std::uint64_t generation = s_ReclaimerGeneration.fetch_add(1, ::std::memory_order_seq_cst) + 1;
+        s_ReclaimerRunning.store(true, ::std::memory_order_seq_cst);
+        s_ReclaimerThread = ::std::thread(ReclaimerMain, generation);
+    }
+
+    // Its generation is stale, it exits once its batch is done.
+    if(retired.joinable())
+    {
+        retired.join();
+    }
+
+    return RC_Success;
+}
+
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComStopReclaimer() noexcept
+{
+    using namespace tau::com;
+
+    ::std::thread stopped;
+
+    {
+        ::std::lock_guard lock(s_ReclaimerControlLock);
+
+        if(!s_ReclaimerRunning.load(::std::memory_order_relaxed))
+        {
+            return RC_NotReady;
+        }
+
+        s_ReclaimerRunning.store(false, ::std::memory_order_seq_cst);
+        s_ReclaimerGeneration.fetch_add(1, ::std::memory_order_seq_cst);
+        s_PendingSignal.fetch_add(1, ::std::memory_order_release);
+        s_PendingSignal.notify_all();
+
+        // A deferred destructor stopping the reclaimer can't join its own
+        // thread, it is retired and returns once that batch is done.
+        if(s_ReclaimerThread.get_id() == ::std::this_thread::get_id())
+        {
+            stopped = TakeRetiredReclaimer();
+            s_RetiredReclaimerThread = ::std::move(s_ReclaimerThread);
+        }
+        else
+        {
+            stopped = ::std::move(s_ReclaimerThread);
+        }
+    }
+
+    // Joined outside the lock, the thread may still be in a deferred
+    // destructor that starts or stops the reclaimer.
+    if(stopped.joinable())
+    {
+        stopped.join();
+    }
+
+    // Anything that saw the reclaimer running is pushed before this returns.
+    while(s_Deferring.load(::std::memory_order_seq_cst) != 0)
+    {
+        ::std::this_thread::yield();
+    }
+
+    TauComDrainReclaimer();
+
+    return RC_Success;
+}
+
+extern "C" TAU_COM_LIB void TauComDrainReclaimer() noexcept
+{
+    using namespace tau::com;
+
+    if(t_InDeferredDestroy)
+    {
+        // Other batches may still be in flight, but waiting on them could
+        // wait on ourselves.
+        while(DrainOnce())
+        { }
+
+        return;
+    }
+
+    while(true)
+    {
+        const bool drained = DrainOnce();
+
+        ::std::uint32_t inFlight;
+        while((inFlight = s_InFlight.load(::std::memory_order_acquire)) != 0)
+        {
+            s_InFlight.wait(inFlight, ::std::memory_order_acquire);
+        }
+
+        if(!drained && !s_Pending.load(::std::memory_order_acquire))
+        {
+            return;
+        }
+    }
+}
@@ -1,5 +1,8 @@
 #include "TauCOM.hpp"
 #include "TauCOM.impl.hpp"
+#include "EventHub.hpp"
+#include <mutex>
+#include <shared_mutex>
 
 #ifdef TAU_COM_USE_TAU_UTILS
 #include <allocator/TauAllocator.hpp>
@@ -7,16 +10,19 @@
 
 namespace tau::com {
 
-class ComManager final : public IComManager1
+class ComManager final : public IComManager3
 {
-    TAU_COM_IMPL_REF_COUNT();
+    TAU_COM_IMPL_SHARDED_REF_COUNT();
+public:
+    using PlacementFactoryMap = ::std::unordered_map<UUID, ::std::pair<ObjectLayout, ComPlacementFactoryFunc>>;
 public:
     ComManager() noexcept = default;
 
-    ~ComManager() noexcept override = default;
+    ~ComManager() noexcept override;
 
     ComManager(const FactoryMap& factories) noexcept;
     ComManager(FactoryMap&& factories) noexcept;
+    ComManager(FactoryMap&& factories, PlacementFactoryMap&& placementFactories) noexcept;
 
     inline ComManager(const ComManager& copy) noexcept;
     inline ComManager(ComManager&& move) noexcept;
@@ -34,10 +40,63 @@ public:
     EResultCode UnregisterIidFactory(const UUID& iid) noexcept override;
     EResultCode GetIidFactory(const UUID& iid, ComFactoryFunc* const factory) noexcept override;
     EResultCode Duplicate(IComManager1** const comManager) noexcept override;
+
+    // IComManager2
+    EResultCode RegisterIidPlacementFactory(const UUID& iid, const ObjectLayout& layout, const ComPlacementFactoryFunc factory) noexcept override;
+    EResultCode UnregisterIidPlacementFactory(const UUID& iid) noexcept override;
+    EResultCode GetIidObjectLayout(const UUID& iid, ObjectLayout* const pLayout) noexcept override;
+    EResultCode CreateObjectInPlace(const UUID& iid, void* const pStorage, const ::std::size_t storageSize, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept override;
+
+    // IComManager3
+    EResultCode CreateObject(const IidHandle iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept override;
+    EResultCode GetIidFactory(const IidHandle iid, ComFactoryFunc* const factory) noexcept override;
 public:
     static EResultCode Factory(const UUID& iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept;
+    static EResultCode PlacementFactory(const UUID& iid, void* const pStorage, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept;
 private:
+    /**
+     * Factories indexed by IidHandle. Chunks are allocated the first time a
+     * handle in their range is looked up and are never moved or freed before
+     * the manager, so finding a cached factory is a few plain atomic loads.
+     * Entries are filled lazily from m_Factories. Misses are cached as
+     * MissingHandleFactory, only a null entry has to consult m_Factories.
+     */
+    struct HandleSlot final
+    {
+        // Written once under the exclusive lock, before Factory is first published.
+        UUID Iid;
+        ::std::atomic<ComFactoryFunc> Factory;
+    };
+
+    static constexpr ::std::uint32_t HandleChunkShift = 10;
+    static constexpr ::std::uint32_t HandleChunkSize = 1u << HandleChunkShift;
+    static constexpr ::std::uint32_t HandleChunkCount = 256;
+
+    // Both return MissingHandleFactory for IIDs without a factory, and null
+    // if the result couldn't be determined or cached.
+    [[nodiscard]] ComFactoryFunc FindHandleFactory(const IidHandle iid, UUID* const pIid) const noexcept;
+    [[nodiscard]] ComFactoryFunc CacheHandleFactory(const IidHandle iid, UUID* const pIid) noexcept;
+
+    [[nodiscard]] HandleSlot* FindHandleSlot(const IidHandle iid) const noexcept;
+    // Requires m_Lock to be held, shared is enough.
+    [[nodiscard]] ComFactoryFunc LookupHandleFactory(HandleSlot& slot) const noexcept;
+
+    // These require m_Lock to be held exclusively.
+    [[nodiscard]] HandleSlot* CreateHandleSlot(const IidHandle iid, const UUID& uuid) noexcept;
+    void UpdateHandleFactory(const UUID& iid, const ComFactoryFunc factory) noexcept;
+    void ClearHandleFactories() noexcept;
+
+    // Never called, marks a handle whose IID has no factory.
+    static EResultCode MissingHandleFactory(const UUID& iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept;
+private:
+    // Guards all of the factory tables. Factories are copied out and invoked without holding it,
+    // so a factory is free to call back into the manager.
+    mutable ::std::shared_mutex m_Lock;
     FactoryMap m_Factories;
+    PlacementFactoryMap m_PlacementFactories;
+    ::std::atomic<::std::atomic<HandleSlot*>*> m_HandleChunks { nullptr };
+    // Each manager exposes its own IEventHub without a separate allocation.
+    InlineAggregate<EventHub> m_Aggregate { static_cast<IComManager3*>(this) };
 };
 
 ComManager::ComManager(const FactoryMap& factories) noexcept
@@ -48,13 +107,44 @@ ComManager::ComManager(FactoryMap&& factories) noexcept
     : m_Factories(::std::move(factories))
 { }
 
-ComManager::ComManager(const ComManager& copy) noexcept
-    : m_Factories(copy.m_Factories)
+ComManager::ComManager(FactoryMap&& factories, PlacementFactoryMap&& placementFactories) noexcept
+    : m_Factories(::std::move(factories))
+    , m_PlacementFactories(::std::move(placementFactories))
 { }
 
+ComManager::~ComManager() noexcept
+{
+    ::std::atomic<HandleSlot*>* const chunks = m_HandleChunks.load(::std::memory_order_acquire);
+
+    if(!chunks)
+    {
+        return;
+    }
+
+    for(::std::uint32_t i = 0; i < HandleChunkCount; ++i)
+    {
+        delete[] chunks[i].load(::std::memory_order_relaxed);
+    }
+
+    delete[] chunks;
+}
+
+ComManager::ComManager(const ComManager& copy) noexcept
+{
+    ::std::shared_lock lock(copy.m_Lock);
+
+    m_Factories = copy.m_Factories;
+    m_PlacementFactories = copy.m_PlacementFactories;
+}
+
 ComManager::ComManager(ComManager&& move) noexcept
-    : m_Factories(::std::move(move.m_Factories))
-{ }
+{
+    ::std::unique_lock lock(move.m_Lock);
+
+    m_Factories = ::std::move(move.m_Factories);
+    m_PlacementFactories = ::std::move(move.m_PlacementFactories);
+    move.ClearHandleFactories();
+}
 
 ComManager& ComManager::operator=(const ComManager& copy) noexcept
 {
@@ -63,7 +153,13 @@ ComManager& ComManager::operator=(const ComManager& copy) noexcept
         return *this;
     }
 
+    ::std::unique_lock lock(m_Lock, ::std::defer_lock);
+    ::std::shared_lock copyLock(copy.m_Lock, ::std::defer_lock);
+    ::std::lock(lock, copyLock);
+
     m_Factories = copy.m_Factories;
+    m_PlacementFactories = copy.m_PlacementFactories;
+    ClearHandleFactories();
 
     return *this;
 }
@@ -75,25 +171,61 @@ ComManager& ComManager::operator=(ComManager&& move) noexcept
         return *this;
     }
 
+    ::std::unique_lock lock(m_Lock, ::std::defer_lock);
+    ::std::unique_lock moveLock(move.m_Lock, ::std::defer_lock);
+    ::std::lock(lock, moveLock);
+
     m_Factories = ::std::move(move.m_Factories);
+    m_PlacementFactories = ::std::move(move.m_PlacementFactories);
+    ClearHandleFactories();
+    move.ClearHandleFactories();
 
     return *this;
 }
 
+// Factories that don't support aggregation ignore AggregationInfo and hand out
+// a plain object, which must never reach a caller expecting IAggregatable.
+[[nodiscard]] static const AggregationInfo* BeginAggregation(const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    const AggregationInfo* const aggregationInfo = FindConstructionInfo<AggregationInfo>(pConstructionInfo);
+
+    if(aggregationInfo)
+    {
+        aggregationInfo->Accepted = false;
+    }
+
+    return aggregationInfo;
+}
+
+[[nodiscard]] static EResultCode EndAggregation(const AggregationInfo* const aggregationInfo, void** const pInterface, const EResultCode result) noexcept
+{
+    if(!aggregationInfo || IsFailure(result) || aggregationInfo->Accepted)
+    {
+        return result;
+    }
+
+    // Every interface pointer starts with its IUnknown.
+    (void) static_cast<IUnknown*>(*pInterface)->ReleaseReference();
+    *pInterface = nullptr;
+    return RC_NoAggregation;
+}
+
 EResultCode ComManager::QueryInterface(const UUID& iid, void** const pInterface) noexcept
 {
+    TAU_COM_TRACE_QUERY_INTERFACE(iid);
+
     if(!pInterface)
     {
         return RC_NullParam;
     }
 
-    if(iid == iid_of<IUnknown> || iid == iid_of<IComManager> || iid == iid_of<IComManager1>)
+    if(iid == iid_of<IUnknown> || iid == iid_of<IComManager> || iid == iid_of<IComManager1> || iid == iid_of<IComManager2> || iid == iid_of<IComManager3>)
     {
-        *pInterface = static_cast<IComManager1*>(this);
+        *pInterface = static_cast<IComManager3*>(this);
     }
     else
     {
-        return RC_InterfaceNotFound;
+        return m_Aggregate.QueryInnerInterface(iid, pInterface);
     }
 
     AddReference();
@@ -107,6 +239,8 @@ EResultCode ComManager::RegisterIidFactory(const UUID& iid, const ComFactoryFunc
         return RC_NullParam;
     }
 
+    ::std::unique_lock lock(m_Lock);
+
     EResultCode ret = RC_Success;
 
     if(m_Factories.contains(iid))
@@ -115,80 +249,531 @@ EResultCode ComManager::RegisterIidFactory(const UUID& iid, const ComFactoryFunc
     }
 
     m_Factories[iid] = factory;
+    UpdateHandleFactory(iid, factory);
 
     return ret;
 }
 
 EResultCode ComManager::CreateObject(const UUID& iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept
 {
-    if(!m_Factories.contains(iid))
+    ComFactoryFunc factory;
+
     {
-        return RC_InterfaceNotFound;
+        ::std::shared_lock lock(m_Lock);
+
+        const auto it = m_Factories.find(iid);
+
+        if(it == m_Factories.end())
+        {
+            return RC_InterfaceNotFound;
+        }
+
+        factory = it->second;
     }
 
-    return m_Factories[iid](iid, pInterface, pConstructionInfo);
+    const AggregationInfo* const aggregationInfo = BeginAggregation(pConstructionInfo);
+
+    TAU_COM_TRACE(TE_FactoryBegin, iid, nullptr);
+    const EResultCode result = EndAggregation(aggregationInfo, pInterface, factory(iid, pInterface, pConstructionInfo));
+    TAU_COM_TRACE(TE_FactoryEnd, iid, nullptr);
+
+    if(IsSuccess(result))
+    {
+        TAU_COM_TRACE(TE_Construct, iid, TraceIdentity(static_cast<const IUnknown*>(*pInterface)));
+    }
+
+    return result;
 }
 
 EResultCode ComManager::UnregisterIidFactory(const UUID& iid) noexcept
 {
+    ::std::unique_lock lock(m_Lock);
+
     if(!m_Factories.contains(iid))
     {
         return RC_InterfaceNotFound;
     }
 
     (void) m_Factories.erase(iid);
+    UpdateHandleFactory(iid, nullptr);
 
     return RC_Success;
 }
 
 EResultCode ComManager::GetIidFactory(const UUID& iid, ComFactoryFunc* const factory) noexcept
 {
-    if(!m_Factories.contains(iid))
+    if(!factory)
+    {
+        return RC_NullParam;
+    }
+
+    ::std::shared_lock lock(m_Lock);
+
+    const auto it = m_Factories.find(iid);
+
+    if(it == m_Factories.end())
     {
         *factory = nullptr;
         return RC_InterfaceNotFound;
     }
 
-    *factory = m_Factories[iid];
+    *factory = it->second;
 
     return RC_Success;
 }
 
 EResultCode ComManager::Duplicate(IComManager1** const comManager) noexcept
 {
-    ConstructionInfo constructionInfo;
-    constructionInfo.Iid = iid_of<IComManager1>;
-    constructionInfo.pNext = nullptr;
-    constructionInfo.Factories = m_Factories;
+    FactoryMap factories;
+    PlacementFactoryMap placementFactories;
+
+    {
+        ::std::shared_lock lock(m_Lock);
+
+        factories = m_Factories;
+        placementFactories = m_PlacementFactories;
+    }
+
+    ConstructionInfoBuilder<1, sizeof(FactoriesExtension)> constructionInfo;
+    (void) constructionInfo.Add<FactoriesExtension>(&factories);
+
+    const EResultCode result = CreateObject(iid_of<IComManager1>, reinterpret_cast<void**>(comManager), constructionInfo.Get());
+
+    if(IsFailure(result) || placementFactories.empty())
+    {
+        return result;
+    }
+
+    ComRef<IComManager2> duplicate;
+    if(IsSuccess((*comManager)->QueryInterface<IComManager2>(duplicate.Load())))
+    {
+        for(const auto& [iid, placementFactory] : placementFactories)
+        {
+            (void) duplicate->RegisterIidPlacementFactory(iid, placementFactory.first, placementFactory.second);
+        }
+    }
 
-    return IComManager::CreateObject<IComManager1>(comManager, &constructionInfo);
+    return result;
 }
 
-EResultCode ComManager::Factory(const UUID& iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept
+EResultCode ComManager::RegisterIidPlacementFactory(const UUID& iid, const ObjectLayout& layout, const ComPlacementFactoryFunc factory) noexcept
 {
-    if(!pInterface)
+    if(!factory)
     {
         return RC_NullParam;
     }
 
-    if(iid != iid_of<IComManager>)
+    if(layout.Size == 0 || layout.Alignment == 0 || (layout.Alignment & (layout.Alignment - 1)) != 0)
+    {
+        return RC_InvalidParam;
+    }
+
+    ::std::unique_lock lock(m_Lock);
+
+    EResultCode ret = RC_Success;
+
+    if(m_PlacementFactories.contains(iid))
+    {
+        ret = RC_FactoryAlreadyRegistered;
+    }
+
+    m_PlacementFactories[iid] = { layout, factory };
+
+    return ret;
+}
+
+EResultCode ComManager::UnregisterIidPlacementFactory(const UUID& iid) noexcept
+{
+    ::std::unique_lock lock(m_Lock);
+
+    if(!m_PlacementFactories.contains(iid))
     {
         return RC_InterfaceNotFound;
     }
 
-    if(pConstructionInfo)
+    (void) m_PlacementFactories.erase(iid);
+
+    return RC_Success;
+}
+
+EResultCode ComManager::GetIidObjectLayout(const UUID& iid, ObjectLayout* const pLayout) noexcept
+{
+    if(!pLayout)
+    {
+        return RC_NullParam;
+    }
+
+    ::std::shared_lock lock(m_Lock);
+
+    const auto it = m_PlacementFactories.find(iid);
+
+    if(it == m_PlacementFactories.end())
     {
-        if(pConstructionInfo->Iid != iid_of<IComManager> && pConstructionInfo->Iid != iid_of<IComManager1>)
+        *pLayout = { 0, 0 };
+        return RC_InterfaceNotFound;
+    }
+
+    *pLayout = it->second.first;
+
+    return RC_Success;
+}
+
+EResultCode ComManager::CreateObjectInPlace(const UUID& iid, void* const pStorage, const ::std::size_t storageSize, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    if(!pStorage || !pInterface)
+    {
+        return RC_NullParam;
+    }
+
+    ComPlacementFactoryFunc factory;
+
+    {
+        ::std::shared_lock lock(m_Lock);
+
+        const auto it = m_PlacementFactories.find(iid);
+
+        if(it == m_PlacementFactories.end())
         {
             return RC_InterfaceNotFound;
         }
 
-        const ConstructionInfo* const constructionInfo = static_cast<const ConstructionInfo*>(pConstructionInfo);
+        if(!IsStorageSuitable(pStorage, storageSize, it->second.first))
+        {
+            return RC_InvalidParam;
+        }
+
+        factory = it->second.second;
+    }
+
+    const AggregationInfo* const aggregationInfo = BeginAggregation(pConstructionInfo);
+
+    TAU_COM_TRACE(TE_FactoryBegin, iid, pStorage);
+    const EResultCode result = EndAggregation(aggregationInfo, pInterface, factory(iid, pStorage, pInterface, pConstructionInfo));
+    TAU_COM_TRACE(TE_FactoryEnd, iid, pStorage);
 
+    if(IsSuccess(result))
+    {
+        TAU_COM_TRACE(TE_Construct, iid, TraceIdentity(static_cast<const IUnknown*>(*pInterface)));
+    }
+
+    return result;
+}
+
+EResultCode ComManager::CreateObject(const IidHandle iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    UUID uuid;
+    ComFactoryFunc factory = FindHandleFactory(iid, &uuid);
+
+    if(!factory)
+    {
+        factory = CacheHandleFactory(iid, &uuid);
+    }
+
+    if(!factory || factory == MissingHandleFactory)
+    {
+        return RC_InterfaceNotFound;
+    }
+
+    const AggregationInfo* const aggregationInfo = BeginAggregation(pConstructionInfo);
+
+    TAU_COM_TRACE(TE_FactoryBegin, uuid, nullptr);
+    const EResultCode result = EndAggregation(aggregationInfo, pInterface, factory(uuid, pInterface, pConstructionInfo));
+    TAU_COM_TRACE(TE_FactoryEnd, uuid, nullptr);
+
+    if(IsSuccess(result))
+    {
+        TAU_COM_TRACE(TE_Construct, uuid, TraceIdentity(static_cast<const IUnknown*>(*pInterface)));
+    }
+
+    return result;
+}
+
+EResultCode ComManager::GetIidFactory(const IidHandle iid, ComFactoryFunc* const factory) noexcept
+{
+    if(!factory)
+    {
+        return RC_NullParam;
+    }
+
+    UUID uuid;
+    ComFactoryFunc found = FindHandleFactory(iid, &uuid);
+
+    if(!found)
+    {
+        found = CacheHandleFactory(iid, &uuid);
+    }
+
+    if(!found || found == MissingHandleFactory)
+    {
+        *factory = nullptr;
+        return RC_InterfaceNotFound;
+    }
+
+    *factory = found;
+    return RC_Success;
+}
+
+ComManager::ComFactoryFunc ComManager::FindHandleFactory(const IidHandle iid, UUID* const pIid) const noexcept
+{
+    const HandleSlot* const slot = FindHandleSlot(iid);
+
+    if(!slot)
+    {
+        return nullptr;
+    }
+
+    const ComFactoryFunc factory = slot->Factory.load(::std::memory_order_acquire);
+
+    if(factory)
+    {
+        *pIid = slot->Iid;
+    }
+
+    return factory;
+}
+
+ComManager::ComFactoryFunc ComManager::CacheHandleFactory(const IidHandle iid, UUID* const pIid) noexcept
+{
+    if(IsFailure(TauComGetInternedIid(iid, pIid)))
+    {
+        return nullptr;
+    }
+
+    {
+        // The slot usually exists already, filling it in only needs m_Factories
+        // to hold still. Concurrent readers store the same value.
+        ::std::shared_lock lock(m_Lock);
+
+        if(HandleSlot* const slot = FindHandleSlot(iid); slot && slot->Iid == *pIid)
+        {
+            return LookupHandleFactory(*slot);
+        }
+
+        if((static_cast<::std::uint32_t>(iid) >> HandleChunkShift) >= HandleChunkCount)
+        {
+            // Such handles are just never cached.
+            const auto it = m_Factories.find(*pIid);
+            return it == m_Factories.end() ? MissingHandleFactory : it->second;
+        }
+    }
+
+    // Only allocating a chunk or claiming a slot needs the exclusive lock.
+    ::std::unique_lock lock(m_Lock);
+
+    HandleSlot* const slot = CreateHandleSlot(iid, *pIid);
+
+    if(!slot)
+    {
+        const auto it = m_Factories.find(*pIid);
+        return it == m_Factories.end() ? MissingHandleFactory : it->second;
+    }
+
+    return LookupHandleFactory(*slot);
+}
+
+ComManager::HandleSlot* ComManager::FindHandleSlot(const IidHandle iid) const noexcept
+{
+    const ::std::uint32_t index = static_cast<::std::uint32_t>(iid);
+
+    if((index >> HandleChunkShift) >= HandleChunkCount)
+    {
+        return nullptr;
+    }
+
+    const ::std::atomic<HandleSlot*>* const chunks = m_HandleChunks.load(::std::memory_order_acquire);
+
+    if(!chunks)
+    {
+        return nullptr;
+    }
+
+    HandleSlot* const chunk = chunks[index >> HandleChunkShift].load(::std::memory_order_acquire);
+
+    if(!chunk)
+    {
+        return nullptr;
+    }
+
+    return &chunk[index & (HandleChunkSize - 1)];
+}
+
+ComManager::ComFactoryFunc ComManager::LookupHandleFactory(HandleSlot& slot) const noexcept
+{
+    const auto it = m_Factories.find(slot.Iid);
+    const ComFactoryFunc factory = it == m_Factories.end() ? MissingHandleFactory : it->second;
+
+    slot.Factory.store(factory, ::std::memory_order_release);
+
+    return factory;
+}
+
+ComManager::HandleSlot* ComManager::CreateHandleSlot(const IidHandle iid, const UUID& uuid) noexcept
+{
+    const ::std::uint32_t index = static_cast<::std::uint32_t>(iid);
+
+    if((index >> HandleChunkShift) >= HandleChunkCount)
+    {
+        return nullptr;
+    }
+
+    ::std::atomic<HandleSlot*>* chunks = m_HandleChunks.load(::std::memory_order_relaxed);
+
+    if(!chunks)
+    {
+        chunks = new(::std::nothrow) ::std::atomic<HandleSlot*>[HandleChunkCount]();
+
+        if(!chunks)
+        {
+            return nullptr;
+        }
+
+        m_HandleChunks.store(chunks, ::std::memory_order_release);
+    }
+
+    HandleSlot* chunk = chunks[index >> HandleChunkShift].load(::std::memory_order_relaxed);
+
+    if(!chunk)
+    {
+        chunk = new(::std::nothrow) HandleSlot[HandleChunkSize]();
+
+        if(!chunk)
+        {
+            return nullptr;
+        }
+
+        chunks[index >> HandleChunkShift].store(chunk, ::std::memory_order_release);
+    }
+
+    HandleSlot& slot = chunk[index & (HandleChunkSize - 1)];
+
+    // Readers only look at Iid after seeing a factory, so it is only written
+    // while no factory has ever been published for the slot.
+    if(slot.Iid == UUID())
+    {
+        slot.Iid = uuid;
+    }
+
+    return &slot;
+}
+
+void ComManager::UpdateHandleFactory(const UUID& iid, const ComFactoryFunc factory) noexcept
+{
+    // Nothing is cached until a handle has been looked up.
+    if(!m_HandleChunks.load(::std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    IidHandle handle;
+
+    if(IsFailure(TauComInternIid(iid, &handle)))
+    {
+        return;
+    }
+
+    // Slots that were never looked up stay empty and are filled on demand.
+    if(HandleSlot* const slot = FindHandleSlot(handle); slot && slot->Iid == iid)
+    {
+        slot->Factory.store(factory ? factory : MissingHandleFactory, ::std::memory_order_release);
+    }
+}
+
+void ComManager::ClearHandleFactories() noexcept
+{
+    ::std::atomic<HandleSlot*>* const chunks = m_HandleChunks.load(::std::memory_order_relaxed);
+
+    if(!chunks)
+    {
+        return;
+    }
+
+    for(::std::uint32_t i = 0; i < HandleChunkCount; ++i)
+    {
+        if(HandleSlot* const chunk = chunks[i].load(::std::memory_order_relaxed))
+        {
+            for(::std::uint32_t j = 0; j < HandleChunkSize; ++j)
+            {
+                chunk[j].Factory.store(nullptr, ::std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+EResultCode ComManager::MissingHandleFactory(const UUID&, void** const, const BaseConstructionInfo* const) noexcept
+{
+    return RC_InterfaceNotFound;
+}
+
+static bool IsComManagerIid(const UUID& iid) noexcept
+{
+    return iid == iid_of<IComManager> || iid == iid_of<IComManager1> || iid == iid_of<IComManager2> || iid == iid_of<IComManager3>;
+}
+
+// Accepts either a FactoriesExtension or the legacy ConstructionInfo as the
+// head of the chain. Without either *pFactories is left null.
+static EResultCode FindFactories(const BaseConstructionInfo* pConstructionInfo, const IComManager::FactoryMap** const pFactories) noexcept
+{
+    // Managers can't be aggregated, the request is left unaccepted and the
+    // caller reports RC_NoAggregation instead of a malformed chain.
+    while(pConstructionInfo && pConstructionInfo->Iid == iid_of<AggregationInfo>)
+    {
+        pConstructionInfo = pConstructionInfo->pNext;
+    }
+
+    if(!pConstructionInfo)
+    {
+        return RC_Success;
+    }
+
+    if(const IComManager::FactoriesExtension* const extension = FindConstructionExtension<IComManager::FactoriesExtension>(pConstructionInfo))
+    {
+        if(!extension->pFactories)
+        {
+            return RC_NullParam;
+        }
+
+        *pFactories = extension->pFactories;
+        return RC_Success;
+    }
+
+    if(PackedConstructionInfo::IsPacked(pConstructionInfo))
+    {
+        return RC_Success;
+    }
+
+    if(!IsComManagerIid(pConstructionInfo->Iid))
+    {
+        return RC_InterfaceNotFound;
+    }
+
+    *pFactories = &static_cast<const IComManager::ConstructionInfo*>(pConstructionInfo)->Factories;
+    return RC_Success;
+}
+
+EResultCode ComManager::Factory(const UUID& iid, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    if(!pInterface)
+    {
+        return RC_NullParam;
+    }
+
+    if(!IsComManagerIid(iid))
+    {
+        return RC_InterfaceNotFound;
+    }
+
+    const FactoryMap* factories = nullptr;
+    if(const EResultCode result = FindFactories(pConstructionInfo, &factories); IsFailure(result))
+    {
+        return result;
+    }
+
+    if(factories)
+    {
 #ifdef TAU_COM_USE_TAU_UTILS
-        *pInterface = BasicTauAllocator<AllocationTracking::None>::Instance().AllocateT<ComManager>(constructionInfo->Factories);
+        *pInterface = BasicTauAllocator<AllocationTracking::None>::Instance().AllocateT<ComManager>(*factories);
 #else
-        *pInterface = new(::std::nothrow) ComManager(constructionInfo->Factories);
+        *pInterface = new(::std::nothrow) ComManager(*factories);
 #endif
     }
     else
@@ -208,7 +793,67 @@ EResultCode ComManager::Factory(const UUID& iid, void** const pInterface, const
     return RC_Success;
 }
 
+EResultCode ComManager::PlacementFactory(const UUID& iid, void* const pStorage, void** const pInterface, const BaseConstructionInfo* const pConstructionInfo) noexcept
+{
+    if(!pStorage || !pInterface)
+    {
+        return RC_NullParam;
+    }
+
+    if(!IsComManagerIid(iid))
+    {
+        return RC_InterfaceNotFound;
+    }
+
+    const FactoryMap* factories = nullptr;
+    if(const EResultCode result = FindFactories(pConstructionInfo, &factories); IsFailure(result))
+    {
+        return result;
+    }
+
+    if(factories)
+    {
+        *pInterface = static_cast<IComManager3*>(ConstructInPlace<ComManager>(pStorage, *factories));
+    }
+    else
+    {
+        *pInterface = static_cast<IComManager3*>(ConstructInPlace<ComManager>(pStorage));
+    }
+
+    return RC_Success;
+}
+
 static ComManager* s_GlobalComManager = nullptr;
+static ::std::once_flag s_GlobalComManagerOnce;
+
+static void InitGlobalComManager() noexcept
+{
+    ComManager::FactoryMap factories;
+    factories[iid_of<IComManager>] = ComManager::Factory;
+    factories[iid_of<IComManager1>] = ComManager::Factory;
+    factories[iid_of<IComManager2>] = ComManager::Factory;
+    factories[iid_of<IComManager3>] = ComManager::Factory;
+    factories[iid_of<IEventHub>] = EventHub::Factory;
+
+    ComManager::PlacementFactoryMap placementFactories;
+    placementFactories[iid_of<IComManager>] = { ObjectLayout::Of<ComManager>(), ComManager::PlacementFactory };
+    placementFactories[iid_of<IComManager1>] = { ObjectLayout::Of<ComManager>(), ComManager::PlacementFactory };
+    placementFactories[iid_of<IComManager2>] = { ObjectLayout::Of<ComManager>(), ComManager::PlacementFactory };
+    placementFactories[iid_of<IComManager3>] = { ObjectLayout::Of<ComManager>(), ComManager::PlacementFactory };
+    placementFactories[iid_of<IEventHub>] = { ObjectLayout::Of<EventHub>(), EventHub::PlacementFactory };
+
+#ifdef TAU_COM_USE_TAU_UTILS
+    s_GlobalComManager = BasicTauAllocator<AllocationTracking::None>::Instance().AllocateT<ComManager>(::std::move(factories), ::std::move(placementFactories));
+#else
+    s_GlobalComManager = new(::std::nothrow) ComManager(::std::move(factories), ::std::move(placementFactories));
+#endif
+
+    if(s_GlobalComManager)
+    {
+        // Every thread shares the global manager for the lifetime of the process.
+        s_GlobalComManager->SwitchReferenceToSharded();
+    }
+}
 
 }
 
@@ -221,17 +866,11 @@ extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComGetComManager(::tau::com::I
         return RC_NullParam;
     }
 
+    ::std::call_once(s_GlobalComManagerOnce, InitGlobalComManager);
+
     if(!s_GlobalComManager)
     {
-        ComManager::FactoryMap factories;
-        factories[iid_of<IComManager>] = ComManager::Factory;
-        factories[iid_of<IComManager1>] = ComManager::Factory;
-
-#ifdef TAU_COM_USE_TAU_UTILS
-        s_GlobalComManager = BasicTauAllocator<AllocationTracking::None>::Instance().AllocateT<ComManager>(::std::move(factories));
-#else
-        s_GlobalComManager = new(::std::nothrow) ComManager(::std::move(factories));
-#endif
+        return RC_OutOfMemory;
     }
 
     *pInterface = s_GlobalComManager;
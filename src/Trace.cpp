@@ -0,0 +1,290 @@
+#include "TauCOM.trace.hpp"
+#include "TauCOM.impl.hpp"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+
+namespace tau::com {
+
+TAU_COM_LIB ::std::atomic<bool> g_TraceEnabled = false;
+
+struct TraceRecordEntry final
+{
+    ::std::uint64_t Timestamp;
+    const void* pObject;
+    UUID Iid;
+    ETraceEvent Event;
+    ::std::uint32_t ThreadId;
+};
+
+/**
+ * Single producer, single consumer ring. The owning thread is the only
+ * writer of m_Head and the flush (under s_FlushLock) the only writer of
+ * m_Tail. Buffers of exited threads are handed to new threads rather than
+ * freed, so the registry list only ever grows.
+ */
+class TraceBuffer final
+{
+public:
+    static inline constexpr ::std::uint64_t Capacity = 8192;
+public:
+    TraceBuffer() noexcept
+        : m_Head(0)
+        , m_Tail(0)
+        , m_InUse(true)
+        , m_Records { }
+        , m_pNext(nullptr)
+    { }
+
+    ~TraceBuffer() noexcept = default;
+
+    TraceBuffer(const TraceBuffer& copy) noexcept = delete;
+    TraceBuffer(TraceBuffer&& move) noexcept = delete;
+    TraceBuffer& operator=(const TraceBuffer& copy) noexcept = delete;
+    TraceBuffer& operator=(TraceBuffer&& move) noexcept = delete;
+
+    void Push(const TraceRecordEntry& record) noexcept
+    {
+        const ::std::uint64_t head = m_Head.load(::std::memory_order_relaxed);
+
+        if(head - m_Tail.load(::std::memory_order_acquire) >= Capacity)
+        {
+            // Full, drop rather than stall the traced thread.
+            return;
+        }
+
+        m_Records[head & (Capacity - 1)] = record;
+        m_Head.store(head + 1, ::std::memory_order_release);
+    }
+
+    template<typename F>
+    void Drain(F&& callback) noexcept
+    {
+        const ::std::uint64_t head = m_Head.load(::std::memory_order_acquire);
+        ::std::uint64_t tail = m_Tail.load(::std::memory_order_relaxed);
+
+        for(; tail != head; ++tail)
+        {
+            callback(m_Records[tail & (Capacity - 1)]);
+        }
+
+        m_Tail.store(tail, ::std::memory_order_release);
+    }
+
+    [[nodiscard]] bool TryClaim() noexcept
+    {
+        bool expected = false;
+        return m_InUse.compare_exchange_strong(expected, true, ::std::memory_order_acq_rel);
+    }
+
+    void Release() noexcept { m_InUse.store(false, ::std::memory_order_release); }
+
+    [[nodiscard]] TraceBuffer* Next() const noexcept { return m_pNext; }
+    void SetNext(TraceBuffer* const next) noexcept { m_pNext = next; }
+private:
+    ::std::atomic<::std::uint64_t> m_Head;
+    ::std::uint8_t m_HeadPadding[64 - sizeof(::std::atomic<::std::uint64_t>)];
+    ::std::atomic<::std::uint64_t> m_Tail;
+    ::std::atomic<bool> m_InUse;
+    TraceRecordEntry m_Records[Capacity];
+    TraceBuffer* m_pNext;
+};
+
+static ::std::atomic<TraceBuffer*> s_TraceBuffers = nullptr;
+static ::std::atomic<::std::uint32_t> s_NextTraceThreadId = 1;
+static ::std::mutex s_FlushLock;
+
+static TraceBuffer* AcquireTraceBuffer() noexcept
+{
+    for(TraceBuffer* buffer = s_TraceBuffers.load(::std::memory_order_acquire); buffer; buffer = buffer->Next())
+    {
+        if(buffer->TryClaim())
+        {
+            return buffer;
+        }
+    }
+
+    TraceBuffer* const buffer = TAU_COM_CREATE(TraceBuffer);
+
+    if(!buffer)
+    {
+        return nullptr;
+    }
+
+    TraceBuffer* head = s_TraceBuffers.load(::std::memory_order_relaxed);
+    do
+    {
+        buffer->SetNext(head);
+    } while(!s_TraceBuffers.compare_exchange_weak(head, buffer, ::std::memory_order_release, ::std::memory_order_relaxed));
+
+    return buffer;
+}
+
+class ThreadTraceState final
+{
+public:
+    ThreadTraceState() noexcept
+        : Buffer(AcquireTraceBuffer())
+        , ThreadId(s_NextTraceThreadId.fetch_add(1, ::std::memory_order_relaxed))
+    { }
+
+    ~ThreadTraceState() noexcept
+    {
+        if(Buffer)
+        {
+            Buffer->Release();
+        }
+    }
+
+    ThreadTraceState(const ThreadTraceState& copy) noexcept = delete;
+    ThreadTraceState(ThreadTraceState&& move) noexcept = delete;
+    ThreadTraceState& operator=(const ThreadTraceState& copy) noexcept = delete;
+    ThreadTraceState& operator=(ThreadTraceState&& move) noexcept = delete;
+public:
+    TraceBuffer* Buffer;
+    ::std::uint32_t ThreadId;
+};
+
+static ::std::uint64_t TraceTimestamp() noexcept
+{
+    return static_cast<::std::uint64_t>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(::std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+TAU_COM_LIB void TraceRecord(const ETraceEvent event, const UUID& iid, const void* const pObject) noexcept
+{
+    thread_local ThreadTraceState t_State;
+
+    if(!t_State.Buffer)
+    {
+        return;
+    }
+
+    t_State.Buffer->Push({ TraceTimestamp(), pObject, iid, event, t_State.ThreadId });
+}
+
+static const char* TraceEventName(const ETraceEvent event) noexcept
+{
+    switch(event)
+    {
+        case TE_FactoryBegin:
+        case TE_FactoryEnd:     return "Factory";
+        case TE_Construct:      return "Construct";
+        case TE_DestroyBegin:
+        case TE_DestroyEnd:     return "Destroy";
+        case TE_QueryInterface: return "QueryInterface";
+        default:                return "Unknown";
+    }
+}
+
+static const char* TraceEventPhase(const ETraceEvent event) noexcept
+{
+    switch(event)
+    {
+        case TE_FactoryBegin:
+        case TE_DestroyBegin: return "B";
+        case TE_FactoryEnd:
+        case TE_DestroyEnd:   return "E";
+        default:              return "i";
+    }
+}
+
+static void WriteChromeRecord(::std::FILE* const file, const TraceRecordEntry& record, bool& first) noexcept
+{
+    ::std::fprintf(file,
+        "%s\n{\"name\":\"%s\",\"cat\":\"TauCOM\",\"ph\":\"%s\",\"s\":\"t\",\"ts\":%" PRIu64 ".%03" PRIu64 ",\"pid\":0,\"tid\":%" PRIu32 ","
+        "\"args\":{\"iid\":\"%016" PRIX64 "-%016" PRIX64 "\",\"object\":\"%p\"}}",
+        first ? "" : ",",
+        TraceEventName(record.Event), TraceEventPhase(record.Event),
+        record.Timestamp / 1000, record.Timestamp % 1000, record.ThreadId,
+        record.Iid.High, record.Iid.Low, record.pObject);
+    first = false;
+}
+
+static void WritePerfRecord(::std::FILE* const file, const TraceRecordEntry& record) noexcept
+{
+    const char* suffix = "";
+
+    if(record.Event == TE_FactoryBegin || record.Event == TE_DestroyBegin)
+    {
+        suffix = "_entry";
+    }
+    else if(record.Event == TE_FactoryEnd || record.Event == TE_DestroyEnd)
+    {
+        suffix = "_exit";
+    }
+
+    ::std::fprintf(file,
+        "TauCOM %" PRIu32 " [000] %" PRIu64 ".%06" PRIu64 ": taucom:%s%s: iid=%016" PRIX64 "-%016" PRIX64 " object=%p\n",
+        record.ThreadId,
+        record.Timestamp / 1000000000, (record.Timestamp / 1000) % 1000000,
+        TraceEventName(record.Event), suffix,
+        record.Iid.High, record.Iid.Low, record.pObject);
+}
+
+}
+
+extern "C" TAU_COM_LIB void TauComTraceSetEnabled(const bool enabled) noexcept
+{
+    ::tau::com::g_TraceEnabled.store(enabled, ::std::memory_order_relaxed);
+}
+
+extern "C" TAU_COM_LIB ::tau::com::EResultCode TauComTraceFlush(const char* const path, const ::tau::com::ETraceFormat format) noexcept
+{
+    using namespace tau::com;
+
+    if(!path)
+    {
+        return RC_NullParam;
+    }
+
+    if(format != TF_ChromeJson && format != TF_PerfScript)
+    {
+        return RC_InvalidParam;
+    }
+
+    ::std::lock_guard lock(s_FlushLock);
+
+    ::std::FILE* const file = ::std::fopen(path, "w");
+
+    if(!file)
+    {
+        return RC_Fail;
+    }
+
+    bool first = true;
+
+    if(format == TF_ChromeJson)
+    {
+        ::std::fputs("{\"traceEvents\":[", file);
+    }
+
+    for(TraceBuffer* buffer = s_TraceBuffers.load(::std::memory_order_acquire); buffer; buffer = buffer->Next())
+    {
+        buffer->Drain([file, format, &first](const TraceRecordEntry& record)
+        {
+            if(format == TF_ChromeJson)
+            {
+                WriteChromeRecord(file, record, first);
+            }
+            else
+            {
+                WritePerfRecord(file, record);
+            }
+        });
+    }
+
+    if(format == TF_ChromeJson)
+    {
+        ::std::fputs("\n],\"displayTimeUnit\":\"ns\"}\n", file);
+    }
+
+    const bool failed = ::std::ferror(file) != 0;
+
+    if(::std::fclose(file) != 0 || failed)
+    {
+        return RC_Fail;
+    }
+
+    return RC_Success;
+}
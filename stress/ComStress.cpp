@@ -0,0 +1,869 @@
+#include "TauCOM.hpp"
+#include "TauCOM.impl.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace tau::com {
+
+class IStressObject : public IUnknown
+{
+public:
+    virtual ::std::uint64_t Touch() noexcept = 0;
+};
+
+}
+
+TAU_DECL_UUID(::tau::com::IStressObject, 0x3E8C1A5F7B92D046ull, 0xA0D45B6E29C1F783ull);
+
+namespace tau::com {
+
+class StressObjectBase : public IStressObject
+{
+protected:
+    StressObjectBase() noexcept = default;
+public:
+    ~StressObjectBase() noexcept override = default;
+
+    StressObjectBase(const StressObjectBase& copy) noexcept = delete;
+    StressObjectBase(StressObjectBase&& move) noexcept = delete;
+    StressObjectBase& operator=(const StressObjectBase& copy) noexcept = delete;
+    StressObjectBase& operator=(StressObjectBase&& move) noexcept = delete;
+
+    EResultCode QueryInterface(const UUID& iid, void** const pInterface) noexcept override
+    {
+        if(!pInterface)
+        {
+            return RC_NullParam;
+        }
+
+        if(iid == iid_of<IUnknown> || iid == iid_of<IStressObject>)
+        {
+            *pInterface = static_cast<IStressObject*>(this);
+        }
+        else
+        {
+            return RC_InterfaceNotFound;
+        }
+
+        AddReference();
+        return RC_Success;
+    }
+
+    ::std::uint64_t Touch() noexcept override { return ++m_Touches; }
+public:
+    template<typename T>
+    static EResultCode Factory(const UUID&, void** const pInterface, const BaseConstructionInfo* const) noexcept
+    {
+        if(!pInterface)
+        {
+            return RC_NullParam;
+        }
+
+        *pInterface = static_cast<IStressObject*>(TAU_COM_CREATE(T));
+        return *pInterface ? RC_Success : RC_OutOfMemory;
+    }
+private:
+    ::std::atomic<::std::uint64_t> m_Touches = 0;
+};
+
+class StressObject final : public StressObjectBase
+{
+    TAU_COM_IMPL_REF_COUNT();
+};
+
+// Destroyed on the reclaimer thread when run with --deferred.
+class DeferredStressObject final : public StressObjectBase
+{
+    TAU_COM_IMPL_DEFERRED_REF_COUNT();
+};
+
+// Uses a sharded count that --workload dying folds while other threads still
+// add and release references on their own shards.
+class DyingStressObject final : public StressObjectBase
+{
+    TAU_COM_IMPL_SHARDED_REF_COUNT();
+public:
+    static inline ::std::atomic<::std::uint64_t> s_Created = 0;
+    static inline ::std::atomic<::std::uint64_t> s_Destroyed = 0;
+public:
+    DyingStressObject() noexcept
+        : m_Alive(true)
+    {
+        s_Created.fetch_add(1, ::std::memory_order_relaxed);
+    }
+
+    ~DyingStressObject() noexcept override
+    {
+        m_Alive = false;
+        s_Destroyed.fetch_add(1, ::std::memory_order_relaxed);
+    }
+
+    DyingStressObject(const DyingStressObject& copy) noexcept = delete;
+    DyingStressObject(DyingStressObject&& move) noexcept = delete;
+    DyingStressObject& operator=(const DyingStressObject& copy) noexcept = delete;
+    DyingStressObject& operator=(DyingStressObject&& move) noexcept = delete;
+
+    // Returns 0 once destroyed, a sanitizer build reports the access itself.
+    ::std::uint64_t Touch() noexcept override { return m_Alive ? StressObjectBase::Touch() : 0; }
+private:
+    bool m_Alive;
+};
+
+// Counts live instances so reclamation of unsubscribed and pruned sinks can be
+// checked. With UnsubscribeOnEvent set the sink unsubscribes itself from
+// inside OnEvents.
+class StressSink final : public IEventSink, public IWeakReferenceSource
+{
+    TAU_COM_IMPL_REF_COUNT();
+    TAU_COM_IMPL_WEAK_REFERENCE_SOURCE();
+public:
+    StressSink(::std::atomic<::std::int64_t>* const live, IEventHub* const hub, const bool unsubscribeOnEvent) noexcept
+        : m_Live(live)
+        , m_Hub(hub)
+        , m_UnsubscribeOnEvent(unsubscribeOnEvent)
+        , m_Cookie(0)
+        , m_UnsubscribeResult(RC_NotReady)
+    {
+        m_Live->fetch_add(1, ::std::memory_order_relaxed);
+    }
+
+    ~StressSink() noexcept override
+    {
+        m_Live->fetch_sub(1, ::std::memory_order_relaxed);
+    }
+
+    StressSink(const StressSink& copy) noexcept = delete;
+    StressSink(StressSink&& move) noexcept = delete;
+    StressSink& operator=(const StressSink& copy) noexcept = delete;
+    StressSink& operator=(StressSink&& move) noexcept = delete;
+
+    EResultCode QueryInterface(const UUID& iid, void** const pInterface) noexcept override
+    {
+        if(!pInterface)
+        {
+            return RC_NullParam;
+        }
+
+        if(iid == iid_of<IUnknown> || iid == iid_of<IEventSink>)
+        {
+            *pInterface = static_cast<IEventSink*>(this);
+        }
+        else if(iid == iid_of<IWeakReferenceSource>)
+        {
+            *pInterface = static_cast<IWeakReferenceSource*>(this);
+        }
+        else
+        {
+            return RC_InterfaceNotFound;
+        }
+
+        AddReference();
+        return RC_Success;
+    }
+
+    void OnEvents(const UUID&, const Event* const, const ::std::size_t) noexcept override
+    {
+        if(!m_UnsubscribeOnEvent)
+        {
+            return;
+        }
+
+        if(const ::std::uint64_t cookie = m_Cookie.exchange(0, ::std::memory_order_acq_rel))
+        {
+            m_UnsubscribeResult.store(m_Hub->Unsubscribe(cookie), ::std::memory_order_release);
+        }
+    }
+
+    void SetCookie(const ::std::uint64_t cookie) noexcept { m_Cookie.store(cookie, ::std::memory_order_release); }
+    [[nodiscard]] EResultCode UnsubscribeResult() const noexcept { return m_UnsubscribeResult.load(::std::memory_order_acquire); }
+private:
+    ::std::atomic<::std::int64_t>* m_Live;
+    IEventHub* m_Hub;
+    bool m_UnsubscribeOnEvent;
+    ::std::atomic<::std::uint64_t> m_Cookie;
+    ::std::atomic<EResultCode> m_UnsubscribeResult;
+};
+
+static constexpr IComManager::ComFactoryFunc StressObjectFactory = StressObjectBase::Factory<StressObject>;
+static constexpr IComManager::ComFactoryFunc DeferredStressObjectFactory = StressObjectBase::Factory<DeferredStressObject>;
+
+// Log2 buckets of nanoseconds, cheap enough to record every operation.
+class LatencyHistogram final
+{
+public:
+    static inline constexpr ::std::size_t BucketCount = 40;
+public:
+    void Record(const ::std::uint64_t nanoseconds) noexcept
+    {
+        ::std::size_t bucket = 0;
+        for(::std::uint64_t value = nanoseconds; value > 1 && bucket < BucketCount - 1; value >>= 1)
+        {
+            ++bucket;
+        }
+
+        ++m_Buckets[bucket];
+        ++m_Count;
+        m_Max = ::std::max(m_Max, nanoseconds);
+    }
+
+    void Merge(const LatencyHistogram& other) noexcept
+    {
+        for(::std::size_t i = 0; i < BucketCount; ++i)
+        {
+            m_Buckets[i] += other.m_Buckets[i];
+        }
+
+        m_Count += other.m_Count;
+        m_Max = ::std::max(m_Max, other.m_Max);
+    }
+
+    // Upper bound of the bucket holding the percentile.
+    [[nodiscard]] ::std::uint64_t Percentile(const double percentile) const noexcept
+    {
+        const ::std::uint64_t target = static_cast<::std::uint64_t>(static_cast<double>(m_Count) * percentile);
+        ::std::uint64_t seen = 0;
+
+        for(::std::size_t i = 0; i < BucketCount; ++i)
+        {
+            seen += m_Buckets[i];
+            if(seen > target)
+            {
+                // Bucket i holds [2^i, 2^(i + 1)), the last one everything above.
+                return ::std::min<::std::uint64_t>((2ull << i) - 1, m_Max);
+            }
+        }
+
+        return m_Max;
+    }
+
+    [[nodiscard]] ::std::uint64_t Count() const noexcept { return m_Count; }
+    [[nodiscard]] ::std::uint64_t Max() const noexcept { return m_Max; }
+private:
+    ::std::array<::std::uint64_t, BucketCount> m_Buckets { };
+    ::std::uint64_t m_Count = 0;
+    ::std::uint64_t m_Max = 0;
+};
+
+enum EWorkload : ::std::uint32_t
+{
+    WL_Create = 1 << 0,
+    WL_Churn = 1 << 1,
+    WL_Pass = 1 << 2,
+    WL_Query = 1 << 3,
+    WL_Mixed = WL_Create | WL_Churn | WL_Pass | WL_Query,
+    // Publishes overlapping subscription changes, weak subscribers dying and
+    // sinks unsubscribing from inside OnEvents.
+    WL_Hub = 1 << 4,
+    // Folds sharded counts while other threads hold and churn references.
+    WL_Dying = 1 << 5,
+};
+
+static constexpr ::std::uint32_t WorkloadOpCount = 6;
+
+struct StressConfig final
+{
+    ::std::uint32_t MaxThreads;
+    ::std::uint32_t DurationMs;
+    ::std::uint32_t Workload;
+    bool Deferred;
+};
+
+static constexpr ::std::size_t MailboxCount = 64;
+
+struct StressShared final
+{
+    IComManager3* Manager;
+    ::std::atomic<bool> Start;
+    ::std::atomic<bool> Stop;
+    // Objects are swapped through these slots to move references across threads.
+    ::std::array<::std::atomic<IStressObject*>, MailboxCount> Mailboxes;
+    IEventHub* Hub;
+    // Sinks created by the workers, all of them must be gone after each step.
+    ::std::atomic<::std::int64_t> LiveSinks;
+};
+
+static const UUID HubTopic(0x5354524553530001ull, 0x70B1Cull);
+
+static UUID ChurnIid(const ::std::uint32_t thread, const ::std::uint64_t iteration) noexcept
+{
+    // Half of the churn lands on a handful of shared IIDs to force contention.
+    if(iteration & 1)
+    {
+        return UUID(0x5354524553530000ull | (iteration & 7), 0xC0FFEEull);
+    }
+
+    return UUID(0x5354524553530000ull | (static_cast<::std::uint64_t>(thread) << 8), 0xC0FFEEull);
+}
+
+// Most operations publish so that publishes keep overlapping subscription
+// changes. Returns false if the hub misbehaved.
+static bool HubOperation(StressShared& shared, const ::std::uint64_t random) noexcept
+{
+    const Event event { HubTopic, nullptr, 0 };
+
+    switch((random >> 8) % 8)
+    {
+        case 0:
+        {
+            // Strong subscription, the hub must drop the sink once unsubscribed.
+            const ComRef<StressSink> sink(TAU_COM_CREATE(StressSink, &shared.LiveSinks, shared.Hub, false));
+            ::std::uint64_t cookie;
+
+            if(!sink || IsFailure(shared.Hub->Subscribe(HubTopic, sink.Get(), SF_None, &cookie)))
+            {
+                return false;
+            }
+
+            (void) shared.Hub->Publish(HubTopic, &event, 1);
+            return IsSuccess(shared.Hub->Unsubscribe(cookie));
+        }
+        case 1:
+        {
+            // Weak subscription whose sink dies straight away, publishes prune it.
+            const ComRef<StressSink> sink(TAU_COM_CREATE(StressSink, &shared.LiveSinks, shared.Hub, false));
+            ::std::uint64_t cookie;
+
+            return sink && IsSuccess(shared.Hub->Subscribe(HubTopic, sink.Get(), SF_Weak, &cookie));
+        }
+        case 2:
+        {
+            // Unsubscribes itself from inside OnEvents, on a topic of its own so
+            // only this publish can deliver to it.
+            const UUID topic(HubTopic.Low, random | 1);
+            const ComRef<StressSink> sink(TAU_COM_CREATE(StressSink, &shared.LiveSinks, shared.Hub, true));
+            ::std::uint64_t cookie;
+
+            if(!sink || IsFailure(shared.Hub->Subscribe(topic, sink.Get(), SF_None, &cookie)))
+            {
+                return false;
+            }
+
+            sink->SetCookie(cookie);
+
+            const Event ownEvent { topic, nullptr, 0 };
+            (void) shared.Hub->Publish(topic, &ownEvent, 1);
+
+            return IsSuccess(sink->UnsubscribeResult()) && shared.Hub->Unsubscribe(cookie) == RC_InvalidParam;
+        }
+        default:
+            return IsSuccess(shared.Hub->Publish(HubTopic, &event, 1));
+    }
+}
+
+// Thread 0 owns each object. It hands references to the other threads through
+// the mailboxes, then folds the count and drops its own reference while they
+// may still be adding and releasing on their shards.
+static bool DyingOperation(StressShared& shared, const ::std::uint32_t thread, const ::std::uint64_t random) noexcept
+{
+    if(thread == 0)
+    {
+        DyingStressObject* const object = TAU_COM_CREATE(DyingStressObject);
+
+        if(!object)
+        {
+            return false;
+        }
+
+        object->SwitchReferenceToSharded();
+
+        for(::std::uint32_t i = 0; i < 4; ++i)
+        {
+            (void) object->AddReference();
+
+            if(IStressObject* const previous = shared.Mailboxes[(random >> (i * 6)) % MailboxCount].exchange(object, ::std::memory_order_acq_rel))
+            {
+                (void) previous->ReleaseReference();
+            }
+        }
+
+        const bool alive = object->MarkReferenceDying() >= 1;
+        (void) object->ReleaseReference();
+        return alive;
+    }
+
+    IStressObject* const object = shared.Mailboxes[random % MailboxCount].exchange(nullptr, ::std::memory_order_acq_rel);
+
+    if(!object)
+    {
+        return true;
+    }
+
+    bool alive = true;
+
+    for(::std::uint32_t i = 0; i < 4; ++i)
+    {
+        (void) object->AddReference();
+        alive &= object->Touch() != 0;
+        (void) object->ReleaseReference();
+    }
+
+    alive &= object->Touch() != 0;
+    (void) object->ReleaseReference();
+    return alive;
+}
+
+static void DrainMailboxes(StressShared& shared) noexcept
+{
+    for(::std::atomic<IStressObject*>& mailbox : shared.Mailboxes)
+    {
+        if(IStressObject* const object = mailbox.exchange(nullptr))
+        {
+            object->ReleaseReference();
+        }
+    }
+}
+
+// Run single threaded after each hub step. Dead weak subscribers must have
+// been pruned and every retired snapshot reclaimed, so no sink is left.
+static bool CheckHubQuiescent(StressShared& shared) noexcept
+{
+    const Event event { HubTopic, nullptr, 0 };
+
+    ::std::uint64_t weakCookie;
+
+    {
+        const ComRef<StressSink> weakSink(TAU_COM_CREATE(StressSink, &shared.LiveSinks, shared.Hub, false));
+
+        if(!weakSink || IsFailure(shared.Hub->Subscribe(HubTopic, weakSink.Get(), SF_Weak, &weakCookie)))
+        {
+            return false;
+        }
+    }
+
+    // Finds the dead subscriber and prunes it. With no other publisher left
+    // the prune reclaims every retired snapshot.
+    (void) shared.Hub->Publish(HubTopic, &event, 1);
+
+    if(shared.Hub->Unsubscribe(weakCookie) != RC_InvalidParam)
+    {
+        return false;
+    }
+
+    return shared.LiveSinks.load(::std::memory_order_relaxed) == 0;
+}
+
+// Blocks inside OnEvents until released, the event carries a publish number.
+class RelaySink final : public IEventSink
+{
+    TAU_COM_IMPL_REF_COUNT();
+public:
+    RelaySink() noexcept
+        : m_Entered(0)
+        , m_Released(0)
+    { }
+
+    ~RelaySink() noexcept override = default;
+
+    RelaySink(const RelaySink& copy) noexcept = delete;
+    RelaySink(RelaySink&& move) noexcept = delete;
+    RelaySink& operator=(const RelaySink& copy) noexcept = delete;
+    RelaySink& operator=(RelaySink&& move) noexcept = delete;
+
+    EResultCode QueryInterface(const UUID& iid, void** const pInterface) noexcept override
+    {
+        if(!pInterface)
+        {
+            return RC_NullParam;
+        }
+
+        if(iid == iid_of<IUnknown> || iid == iid_of<IEventSink>)
+        {
+            *pInterface = static_cast<IEventSink*>(this);
+        }
+        else
+        {
+            return RC_InterfaceNotFound;
+        }
+
+        AddReference();
+        return RC_Success;
+    }
+
+    void OnEvents(const UUID&, const Event* const pEvents, const ::std::size_t) noexcept override
+    {
+        const ::std::uint64_t number = *static_cast<const ::std::uint64_t*>(pEvents->pData);
+
+        m_Entered.fetch_add(1, ::std::memory_order_acq_rel);
+
+        while(m_Released.load(::std::memory_order_acquire) < number)
+        {
+            ::std::this_thread::yield();
+        }
+    }
+
+    void WaitEntered(const ::std::uint64_t count) const noexcept
+    {
+        while(m_Entered.load(::std::memory_order_acquire) < count)
+        {
+            ::std::this_thread::yield();
+        }
+    }
+
+    void Release(const ::std::uint64_t number) noexcept { m_Released.store(number, ::std::memory_order_release); }
+private:
+    ::std::atomic<::std::uint64_t> m_Entered;
+    ::std::atomic<::std::uint64_t> m_Released;
+};
+
+// Keeps a publish in flight at all times by starting the next one before the
+// previous one returns. An unsubscribed sink must still be released.
+static bool CheckHubReclaimsWhilePublishing(StressShared& shared) noexcept
+{
+    static const UUID RelayTopic(HubTopic.Low, 0x4E1A7ull);
+    static const UUID IdleTopic(HubTopic.Low, 0x1D1Eull);
+    static constexpr ::std::uint64_t RelayCount = 4;
+
+    const ComRef<RelaySink> relay(TAU_COM_CREATE(RelaySink));
+    ::std::uint64_t relayCookie;
+
+    if(!relay || IsFailure(shared.Hub->Subscribe(RelayTopic, relay.Get(), SF_None, &relayCookie)))
+    {
+        return false;
+    }
+
+    ::std::atomic<::std::int64_t> live = 0;
+    ::std::uint64_t victimCookie;
+
+    {
+        const ComRef<StressSink> victim(TAU_COM_CREATE(StressSink, &live, shared.Hub, false));
+
+        if(!victim || IsFailure(shared.Hub->Subscribe(HubTopic, victim.Get(), SF_None, &victimCookie)))
+        {
+            return false;
+        }
+    }
+
+    ::std::uint64_t numbers[RelayCount + 1];
+    ::std::thread publishers[RelayCount + 1];
+
+    const auto publish = [&shared](const ::std::uint64_t* const number) noexcept
+    {
+        const Event event { RelayTopic, number, sizeof(*number) };
+        (void) shared.Hub->Publish(RelayTopic, &event, 1);
+    };
+
+    numbers[1] = 1;
+    publishers[1] = ::std::thread(publish, &numbers[1]);
+    relay->WaitEntered(1);
+
+    bool unsubscribed = IsSuccess(shared.Hub->Unsubscribe(victimCookie));
+
+    for(::std::uint64_t i = 2; i <= RelayCount; ++i)
+    {
+        numbers[i] = i;
+        publishers[i] = ::std::thread(publish, &numbers[i]);
+        relay->WaitEntered(i);
+
+        relay->Release(i - 1);
+        publishers[i - 1].join();
+
+        // Any subscription change gives the hub a chance to reclaim.
+        ::std::uint64_t cookie;
+        if(IsSuccess(shared.Hub->Subscribe(IdleTopic, relay.Get(), SF_None, &cookie)))
+        {
+            (void) shared.Hub->Unsubscribe(cookie);
+        }
+    }
+
+    const bool reclaimed = live.load(::std::memory_order_relaxed) == 0;
+
+    relay->Release(RelayCount);
+    publishers[RelayCount].join();
+
+    (void) shared.Hub->Unsubscribe(relayCookie);
+
+    return unsubscribed && reclaimed;
+}
+
+static void StressWorker(StressShared& shared, const StressConfig& config, const ::std::uint32_t thread, LatencyHistogram& histogram, ::std::uint64_t& failures) noexcept
+{
+    ::std::uint32_t ops[WorkloadOpCount];
+    ::std::uint32_t opCount = 0;
+
+    for(::std::uint32_t op = 0; op < WorkloadOpCount; ++op)
+    {
+        if(config.Workload & (1u << op))
+        {
+            ops[opCount++] = 1u << op;
+        }
+    }
+
+    while(!shared.Start.load(::std::memory_order_acquire))
+    {
+        ::std::this_thread::yield();
+    }
+
+    ::std::uint64_t iteration = 0;
+    ::std::uint64_t random = 0x9E3779B97F4A7C15ull * (thread + 1);
+
+    while(!shared.Stop.load(::std::memory_order_relaxed))
+    {
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+
+        const ::std::uint32_t op = ops[random % opCount];
+        const auto begin = ::std::chrono::steady_clock::now();
+
+        switch(op)
+        {
+            case WL_Create:
+            {
+                ComRef<IStressObject> object;
+                if(IsFailure(shared.Manager->CreateObject<IStressObject>(object.Load())))
+                {
+                    ++failures;
+                }
+                break;
+            }
+            case WL_Churn:
+            {
+                const UUID iid = ChurnIid(thread, iteration);
+                (void) shared.Manager->RegisterIidFactory(iid, StressObjectFactory);
+
+                IUnknown* object;
+                if(IsSuccess(shared.Manager->CreateObject(iid, reinterpret_cast<void**>(&object), nullptr)))
+                {
+                    object->ReleaseReference();
+                }
+
+                (void) shared.Manager->UnregisterIidFactory(iid);
+                break;
+            }
+            case WL_Pass:
+            {
+                IStressObject* object;
+                if(IsFailure(shared.Manager->CreateObject<IStressObject>(&object)))
+                {
+                    ++failures;
+                    break;
+                }
+
+                IStressObject* const previous = shared.Mailboxes[random % MailboxCount].exchange(object, ::std::memory_order_acq_rel);
+                if(previous)
+                {
+                    // Takes over the reference the mailbox held.
+                    const ComRef<IStressObject> taken(previous);
+                    (void) taken->Touch();
+                }
+                break;
+            }
+            case WL_Query:
+            {
+                ComRef<IComManager1> manager;
+                if(IsFailure(shared.Manager->QueryInterface<IComManager1>(manager.Load())))
+                {
+                    ++failures;
+                    break;
+                }
+
+                IComManager::ComFactoryFunc factory;
+                if(IsFailure(manager->GetIidFactory(iid_of<IStressObject>, &factory)))
+                {
+                    ++failures;
+                }
+                break;
+            }
+            case WL_Hub:
+            {
+                if(!HubOperation(shared, random))
+                {
+                    ++failures;
+                }
+                break;
+            }
+            case WL_Dying:
+            {
+                if(!DyingOperation(shared, thread, random))
+                {
+                    ++failures;
+                }
+                break;
+            }
+            default: break;
+        }
+
+        const auto end = ::std::chrono::steady_clock::now();
+        histogram.Record(static_cast<::std::uint64_t>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - begin).count()));
+        ++iteration;
+    }
+}
+
+static void RunStep(StressShared& shared, const StressConfig& config, const ::std::uint32_t threadCount) noexcept
+{
+    ::std::vector<LatencyHistogram> histograms(threadCount);
+    ::std::vector<::std::uint64_t> failures(threadCount, 0);
+    ::std::vector<::std::thread> threads;
+    threads.reserve(threadCount);
+
+    shared.Start.store(false, ::std::memory_order_relaxed);
+    shared.Stop.store(false, ::std::memory_order_relaxed);
+
+    for(::std::uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back(StressWorker, ::std::ref(shared), ::std::cref(config), i, ::std::ref(histograms[i]), ::std::ref(failures[i]));
+    }
+
+    const auto begin = ::std::chrono::steady_clock::now();
+    shared.Start.store(true, ::std::memory_order_release);
+    ::std::this_thread::sleep_for(::std::chrono::milliseconds(config.DurationMs));
+
+    shared.Stop.store(true, ::std::memory_order_relaxed);
+
+    for(::std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    ::std::uint64_t checkFailures = 0;
+
+    if((config.Workload & WL_Hub) && !CheckHubReclaimsWhilePublishing(shared))
+    {
+        ++checkFailures;
+    }
+
+    if((config.Workload & WL_Hub) && !CheckHubQuiescent(shared))
+    {
+        ++checkFailures;
+    }
+
+    if(config.Workload & WL_Dying)
+    {
+        // Every folded object must have been destroyed exactly once.
+        DrainMailboxes(shared);
+
+        if(DyingStressObject::s_Created.load(::std::memory_order_relaxed) != DyingStressObject::s_Destroyed.load(::std::memory_order_relaxed))
+        {
+            ++checkFailures;
+        }
+    }
+
+    const double seconds = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - begin).count();
+
+    LatencyHistogram total;
+    ::std::uint64_t totalFailures = checkFailures;
+
+    for(::std::uint32_t i = 0; i < threadCount; ++i)
+    {
+        total.Merge(histograms[i]);
+        totalFailures += failures[i];
+    }
+
+    const double opsPerSecond = static_cast<double>(total.Count()) / seconds;
+
+    ::std::printf("%7" PRIu32 " %14.0f %14.0f %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %8" PRIu64 "\n",
+        threadCount, opsPerSecond, opsPerSecond / threadCount,
+        total.Percentile(0.5), total.Percentile(0.99), total.Percentile(0.999), total.Max(), totalFailures);
+    ::std::fflush(stdout);
+}
+
+static void PrintUsage(const char* const program) noexcept
+{
+    ::std::printf("Usage: %s [--threads N] [--duration MS] [--workload mixed|create|churn|pass|query|hub|dying] [--deferred]\n", program);
+}
+
+}
+
+int main(int argCount, char* args[])
+{
+    using namespace tau::com;
+
+    StressConfig config { ::std::max(1u, ::std::thread::hardware_concurrency()), 1000, WL_Mixed, false };
+
+    for(int i = 1; i < argCount; ++i)
+    {
+        if(::std::strcmp(args[i], "--threads") == 0 && i + 1 < argCount)
+        {
+            config.MaxThreads = static_cast<::std::uint32_t>(::std::max(1, ::std::atoi(args[++i])));
+        }
+        else if(::std::strcmp(args[i], "--duration") == 0 && i + 1 < argCount)
+        {
+            config.DurationMs = static_cast<::std::uint32_t>(::std::max(1, ::std::atoi(args[++i])));
+        }
+        else if(::std::strcmp(args[i], "--deferred") == 0)
+        {
+            config.Deferred = true;
+        }
+        else if(::std::strcmp(args[i], "--workload") == 0 && i + 1 < argCount)
+        {
+            const char* const workload = args[++i];
+
+            if(::std::strcmp(workload, "mixed") == 0)       { config.Workload = WL_Mixed; }
+            else if(::std::strcmp(workload, "create") == 0) { config.Workload = WL_Create; }
+            else if(::std::strcmp(workload, "churn") == 0)  { config.Workload = WL_Churn; }
+            else if(::std::strcmp(workload, "pass") == 0)   { config.Workload = WL_Pass; }
+            else if(::std::strcmp(workload, "query") == 0)  { config.Workload = WL_Query; }
+            else if(::std::strcmp(workload, "hub") == 0)    { config.Workload = WL_Hub; }
+            else if(::std::strcmp(workload, "dying") == 0)  { config.Workload = WL_Dying; }
+            else
+            {
+                PrintUsage(args[0]);
+                return 1;
+            }
+        }
+        else
+        {
+            PrintUsage(args[0]);
+            return 1;
+        }
+    }
+
+    IComManager* comManager;
+    if(IsFailure(TauComGetComManager(&comManager)))
+    {
+        ::std::printf("Failed to get global ComManager.\n");
+        return -101;
+    }
+
+    StressShared shared { };
+    if(IsFailure(comManager->QueryInterface<IComManager3>(&shared.Manager)))
+    {
+        ::std::printf("Global ComManager does not implement IComManager3.\n");
+        return -102;
+    }
+
+    (void) shared.Manager->RegisterIidFactory(iid_of<IStressObject>, config.Deferred ? DeferredStressObjectFactory : StressObjectFactory);
+
+    if(IsFailure(shared.Manager->CreateObject<IEventHub>(&shared.Hub)))
+    {
+        ::std::printf("Failed to create an EventHub.\n");
+        return -103;
+    }
+
+    if(config.Deferred)
+    {
+        (void) TauComStartReclaimer();
+    }
+
+    ::std::printf("%7s %14s %14s %10s %10s %10s %10s %8s\n", "threads", "ops/s", "ops/s/thread", "p50 ns", "p99 ns", "p99.9 ns", "max ns", "fails");
+
+    for(::std::uint32_t threads = 1; ; threads *= 2)
+    {
+        RunStep(shared, config, ::std::min(threads, config.MaxThreads));
+
+        if(threads >= config.MaxThreads)
+        {
+            break;
+        }
+    }
+
+    DrainMailboxes(shared);
+
+    if(config.Deferred)
+    {
+        (void) TauComStopReclaimer();
+    }
+
+    (void) shared.Manager->UnregisterIidFactory(iid_of<IStressObject>);
+    shared.Hub->ReleaseReference();
+    shared.Manager->ReleaseReference();
+
+    return 0;
+}